@@ -0,0 +1,27 @@
+#ifndef __Accumulator_h__
+#define __Accumulator_h__
+
+#include "Radon.h"
+
+template<class T>
+class Accumulator {// filtered backprojection one direction at a time
+private:
+    int n,m;// number of X-rays per direction and directions of sinogram
+    int M,N;// height and width of image
+    int count;// number of projections added
+    double X,Y,R,dr,dth;// geometry of BackScan (CT.cpp)
+    const FFT<T>& F;
+    const Filter<T>& H;
+    Mat<T> B;// sum of backprojections
+    Vec<T> g;// filtered projection
+    Vec<T> y;// columns of image
+public:
+    Accumulator(int, int, int=0, int=0, int=RAMP, double=1);
+    inline int added() const { return count; }
+    void add(const T*, int, int=1);
+    void add(const Mat<T>&, int);
+    void snapshot(Mat<T>&) const;
+    void clear();
+};
+
+#endif // __Accumulator_h__
@@ -0,0 +1,41 @@
+// aligned storage of Vec, Mat and Mat3D
+
+#ifndef __Alloc_h__
+#define __Alloc_h__
+
+#include<cstdlib>
+#include<new>
+#include<atomic>
+#include<type_traits>
+
+const int Alignment(64);// bytes (cache line and AVX-512 register)
+
+inline std::atomic<long> Allocations(0);// number of calls to AlignedAlloc
+inline std::atomic<long> AllocatedBytes(0);// bytes allocated by AlignedAlloc
+
+template <class T>
+inline int AlignedLength(int n)
+// n rounded up so that rows of length n stay aligned
+{
+    const int k(Alignment % sizeof(T) ? 1 : Alignment/sizeof(T));
+    return (n+k-1)/k*k;
+}
+
+template <class T>
+inline T *AlignedAlloc(long n)
+// uninitialized array of n elements on Alignment boundary
+{
+    static_assert(std::is_trivial<T>::value, "element must be trivial");
+    if (n<=0) return 0;
+    size_t b((n*sizeof(T) + Alignment-1)/Alignment*Alignment);
+    void *p(std::aligned_alloc(Alignment, b));
+    if (p==0) throw std::bad_alloc();
+    Allocations++;
+    AllocatedBytes += b;
+    return (T*)p;
+}
+
+template <class T>
+inline void AlignedFree(T *p) { std::free(p); }
+
+#endif // __Alloc_h__
@@ -0,0 +1,23 @@
+#ifndef __Butterfly_h__
+#define __Butterfly_h__
+
+#include "nr.h"
+
+// steps of Brady's butterfly in fast Radon transform (FastCT.cpp)
+// work planes are stored column by column: w[j][i] = a[i][j]
+
+enum { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };// instruction sets
+
+int SimdLevel();
+void SetSimdLevel(int);// lowered to what cpu supports
+
+template<class T> void butterfly(T*, T*, const T*, const T*, int);
+template<class T> void butterfly4(T**, const T*, const T*, const T*, const T*, int);
+template<class T> void sum(T*, const T*, const T*, int);
+template<class T> void ScanStep(Mat<T>&, const Mat<T>&, int, int, int, int);
+template<class T> void BackScanStep(Mat<T>&, const Mat<T>&, int, int, int, int);
+template<class T> void AdjointStep(Mat<T>&, const Mat<T>&, int, int, int, int);
+template<class T> void ScanStep4(Mat<T>&, const Mat<T>&, int, int, int, int);
+template<class T> void BackScanStep4(Mat<T>&, const Mat<T>&, int, int, int, int);
+
+#endif // __Butterfly_h__
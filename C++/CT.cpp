@@ -1,10 +1,11 @@
 #include "Radon.h"
 #include<cmath>
+#include<limits>
 
 static double PI(atan(1)*4);
-static double PI2(PI/2);
 
-void scan(Mat_DP& B, const Mat_DP& A)
+template<class T>
+void scan(Mat<T>& B, const Mat<T>& A)
 // B = sinogram (Radon transform) of image A
 // input:
 //   A = image data (shape (M,N))
@@ -14,6 +15,12 @@ void scan(Mat_DP& B, const Mat_DP& A)
 //   m = B.ncols() = number of directions of X-ray
 //   if n==0, n is set to power of 2 (>M) and
 //            m is set to 2*n
+//   (as RadonFromSinogram in FastCT.cpp requires)
+//   n need not be power of 2; scan costs n*n*m, filtering
+//   m*n*log(n) and BackScan M*N*m, so that n = FFTLength(M+1)
+//   (smallest n filtered without padding) with m = 2n is
+//   cheapest, e.g. n=640 instead of 1024 for M=600 restores
+//   the image in about half the time (bench sizes)
 // output: B = sinogram of A (shape(n,m))
 {
     if(B.nrows()==0) {
@@ -21,92 +28,319 @@ void scan(Mat_DP& B, const Mat_DP& A)
         while(n <= A.nrows()) n<<=1;
         B.SetDims(n, n<<1);
     }
-    int i,j,k;
     int M(A.nrows()),N(A.ncols());
     int n(B.nrows()),m(B.ncols());
     double X((M-1)/2.), Y((N-1)/2.), R(sqrt(X*X + Y*Y));
     double dr(2*R/(n-1)), dth(PI/m);
-    double r,s,theta,cth,sth,x1,y1;
-    Vec_DP x(M), y(N);
-    for(i=0; i<M; i++) x[i] = i-X;
-    for(j=0; j<N; j++) y[j] = j-Y;
-    for(j=0; j<m; j++) {// 0 <= theta < pi
-        theta = j*dth;
-        cth = cos(theta);
-        sth = sin(theta);
-        for(i=0; i<n; i++) {// number of parallel X-rays
-            r = i*dr - R;
-            B[i][j] = 0;
-            for(k=0; k<n; k++) {// integration along X-ray
-                s = k*dr - R;
-                x1 = r*cth - s*sth;
-                y1 = r*sth + s*cth;
-                B[i][j] += interp2d(x1,y1,x,y,A,0);
+    Grid x(-X,1,M), y(-Y,1,N);
+    parallel_for(m, [&](int j0, int j1) {
+        int i,j,k;
+        double r,s,theta,cth,sth,b;
+        thread_local Vec_DP x1, y1;// scratch reused by each thread
+        thread_local Vec<T> z;
+        if(x1.size() < n) x1.SetLength(n);
+        if(y1.size() < n) y1.SetLength(n);
+        if(z.size() < n) z.SetLength(n);
+        for(j=j0; j<j1; j++) {// 0 <= theta < pi
+            theta = j*dth;
+            cth = cos(theta);
+            sth = sin(theta);
+            for(i=0; i<n; i++) {// number of parallel X-rays
+                r = i*dr - R;
+                for(k=0; k<n; k++) {// sample points along X-ray
+                    s = k*dr - R;
+                    x1[k] = r*cth - s*sth;
+                    y1[k] = r*sth + s*cth;
+                }
+                interp2d(&z[0], &x1[0], &y1[0], n, x, y, A, 0);
+                for(b=0, k=0; k<n; k++) b += z[k];// integration
+                B[i][j] = b;
             }
         }
+    });
+}
+
+template<class T>
+void scan(Mat<T>& B, const Mat<T>& A, int mode)
+// B = sinogram of A by projector mode
+// mode = SCAN_SAMPLED: scan(B,A) above
+//        SCAN_JOSEPH: Joseph's method, i.e., exact integral
+//          of A interpolated linearly along the axis (x or y)
+//          closer to normal of X-ray, with one sample per
+//          pixel row or column crossed; B is scaled by 1/dr
+//          to be comparable with SCAN_SAMPLED
+// input, output: same as scan(B,A)
+// each X-ray is clipped to the rows or columns where it is
+//   inside the image before sampling, and cos,sin are
+//   computed once per direction
+// reference: P. M. Joseph, "An Improved Algorithm for
+//   Reprojecting Rays through Pixel Images" IEEE Transactions
+//   on Medical Imaging 1 (1982) 192
+{
+    if(mode==SCAN_SAMPLED) { scan(B,A); return; }
+    if(mode!=SCAN_JOSEPH) error("unknown scan mode");
+    if(B.nrows()==0) {
+        int n(1);
+        while(n <= A.nrows()) n<<=1;
+        B.SetDims(n, n<<1);
     }
+    int M(A.nrows()),N(A.ncols());
+    int n(B.nrows()),m(B.ncols());
+    double X((M-1)/2.), Y((N-1)/2.), R(sqrt(X*X + Y*Y));
+    double dr(2*R/(n-1)), dth(PI/m);
+    long la(A.stride());
+    parallel_for(m, [&](int j0, int j1) {
+        int i,j,k,k0,k1,l,L,K;
+        double r,c,s,u,u0,du,w,a,e,b;
+        bool t;
+        for(j=j0; j<j1; j++) {// 0 <= theta < pi
+            c = cos(j*dth);
+            s = sin(j*dth);
+            t = (fabs(c) < fabs(s));// step along rows if true
+            if(t) { SWAP(c,s); L=N; K=M; }
+            else { L=M; K=N; }
+            // X-ray: x*c + y*s = r; sample k (0<=k<K) of the
+            //   stepping axis is at index u0 + k*du of the other
+            du = -s/c;
+            w = 1/(fabs(c)*dr);
+            for(i=0; i<n; i++) {
+                r = i*dr - R;
+                u0 = (t ? (r + X*s)/c + Y : (r + Y*s)/c + X);
+                // clip to 0 <= u0 + k*du <= L-1 (a <= k <= e)
+                if(du > 0) { a = -u0/du; e = (L-1-u0)/du; }
+                else if(du < 0) { a = (L-1-u0)/du; e = -u0/du; }
+                else if(u0 >= 0 && u0 <= L-1) { a = 0; e = K-1; }
+                else { a = 0; e = -1; }
+                k0 = int(MIN(MAX(floor(a), 0.), double(K)));
+                k1 = int(MAX(MIN(ceil(e), K-1.), -1.));
+                for(; k0<=k1; k0++) {// rounding at ends
+                    u = u0 + k0*du;
+                    if(u>=0 && u<=L-1) break;
+                }
+                for(; k1>=k0; k1--) {
+                    u = u0 + k1*du;
+                    if(u>=0 && u<=L-1) break;
+                }
+                const T *p(A[0]);
+                long dk(t ? la : 1), dl(t ? 1 : la);// strides of k,l
+                if(L==1) {// single row or column: u = 0
+                    for(b=0, k=k0; k<=k1; k++) b += p[k*dk];
+                    B[i][j] = b*w;
+                    continue;
+                }
+                for(b=0, k=k0; k<=k1; k++) {
+                    u = u0 + k*du;
+                    l = int(u);
+                    if(l==L-1) l--;
+                    u -= l;
+                    const T *q(p + k*dk + l*dl);
+                    b += (1-u)*q[0] + u*q[dl];
+                }
+                B[i][j] = b*w;
+            }
+        }
+    });
 }
 
-void filtering(Mat_DP& B, const Mat_DP& A)
+template<class T>
+void filtering(Mat<T>& B, const Mat<T>& A, int window, double cutoff)
 // B = high-pass filter applied to A along axis=0
 // &A==&B is allowed
+// window, cutoff = see Filter in fft.cpp
+// columns are filtered in blocks of nb by interleaved FFT
+//   so that A and B are accessed row by row
+// FFT length is FFTLength(n) (see fft.cpp), so that columns
+//   are padded with zeros only if n is not such a length
+{
+    int n(FFTLength(A.nrows()));
+    filtering(B, A, GetFFT<T>(n), GetFilter<T>(n,window,cutoff));
+}
+
+template<class T>
+void filtering(Mat<T>& B, const Mat<T>& A, const FFT<T>& F, const Filter<T>& H)
+// filtering by plan F and filter H of length not less than
+//   A.nrows() (columns are padded with zeros)
 {
-    int i,j,n(A.nrows()),m(A.ncols());
-    if(n&(n-1)) error("n must be power of 2");
-    double c(PI/n),c2(2./n);
-    Vec_DP v(n);
+    int n(A.nrows()),m(A.ncols());
     B.SetDims(n,m);
-    for(j=0; j<m; j++) {
-        for(i=0; i<n; i++) v[i] = A[i][j];
-        realft(v,1);// FFT
-        v[0] = 0;
-        v[1] *= PI2;
-        for(i=2; i<n; i++) v[i] *= (i>>1)*c;
-        realft(v,-1);// inverse FFT
-        for(i=0; i<n; i++) B[i][j] = v[i]*c2;
-    }
+    filtering(B[0], B.stride(), A[0], A.stride(), n, m, F, H);
 }
 
-void BackScan(Mat_DP& B, const Mat_DP& A)
+template<class T>
+void filtering(T *b, int lb, const T *a, int la, int n, int m,
+               const FFT<T>& F, const Filter<T>& H)
+// filtering of n*m matrices with strides la,lb (a==b is allowed):
+//   b[i*lb+j] = high-pass filter applied to a[i*la+j] along i
+// F.size() may exceed n, in which case a is padded with zeros
+{
+    int nb(16),L(F.size());
+    if(L<n || H.size()!=L) error("plan of wrong length");
+    parallel_for((m+nb-1)/nb, [&](int j0, int j1) {
+        int i,j,k,l;
+        T *w;
+        thread_local Vec<T> v;// scratch reused by each thread
+        if(v.size() < L*nb) v.SetLength(L*nb);
+        for(j=j0*nb; j<j1*nb && j<m; j+=nb) {
+            l = MIN(nb,m-j);// number of columns
+            for(i=0, w=&v[0]; i<n; i++, w+=l)
+                for(k=0; k<l; k++) w[k] = a[long(i)*la+j+k];
+            for(; i<L; i++, w+=l)
+                for(k=0; k<l; k++) w[k] = 0;
+            F.forward(&v[0],l);
+            H.apply(&v[0],l);
+            F.inverse(&v[0],l);
+            for(i=0, w=&v[0]; i<n; i++, w+=l)
+                for(k=0; k<l; k++) b[long(i)*lb+j+k] = w[k];
+        }
+    });
+}
+
+template<class T>
+void BackScan(Mat<T>& B, const Mat<T>& A)
+{
+    Workspace<T> ws;
+    BackScan(B,A,ws);
+}
+
+template<class T>
+void BackScan(Mat<T>& B, const Mat<T>& A, Workspace<T>& ws)
 // B = inverse Radon transform of sinogram A
 // input:
 //   A = sinogram after filtering (shape(n,m))
+//   ws = tables reused between calls
 //   M,N = B.nrows(),B.ncols()
 //       = height and width of output image
 //   if M==0, M,N are both set to n/2
 // ouput: B = image restored from A (shape(M,N))
 {
-    int n(A.nrows()), m(A.ncols());
+    int n(A.nrows());
     if(B.nrows()==0) B.SetDims(n>>1, n>>1);
-    int i,j,k;
-    int M(B.nrows()), N(B.ncols());
+    BackScan(B, A, Region(0, 0, 1, B.nrows(), B.ncols()), ws);
+}
+
+template<class T>
+void BackScan(Mat<T>& B, const Mat<T>& A, const Region& g, Workspace<T>& ws)
+// B = region g of inverse Radon transform of sinogram A
+// input:
+//   A = sinogram after filtering (shape(n,m))
+//   g = region of output in full image of shape (g.M, g.N)
+//       (both n/2 if g.M==0); pixel (i,j) of B is at
+//       (g.i0 + i*g.pitch, g.j0 + j*g.pitch) in full image
+//   ws = tables reused between calls
+//   B.nrows(),B.ncols() = shape of output region
+// ouput: B = image restored from A in region g;
+//   cost is proportional to number of pixels of B
+// r-axis of A is uniform, so that interpolation index
+//   is found by direct arithmetic instead of bisection,
+//   and cos,sin are tabulated for all directions
+{
+    int n(A.nrows()), m(A.ncols());
+    int M(g.M ? g.M : n>>1), N(g.M ? g.N : n>>1);
     double X((M-1)/2.), Y((N-1)/2.), R(sqrt(X*X + Y*Y));
+    M = B.nrows();
+    N = B.ncols();
+    thread_local Vec<T> y1;// scratch reused by each caller
+    if(y1.size() < N) y1.SetLength(N);
+    Vec<T>& y(y1);// columns of B in full image
+    for(int j=0; j<N; j++) y[j] = g.j0 + j*g.pitch;
     double dr(2*R/(n-1)), dth(PI/m);
-    double x,y,r1,theta;
-    Vec_DP r(n),f[m];
-    for(i=0; i<n; i++) r[i] = i*dr - R;
-    for(k=0; k<m; k++) {
-        f[k].SetLength(n);
-        for(i=0; i<n; i++) f[k][i] = A[i][k];
-    }
-    for(i=0; i<M; i++) {
-        x = i-X;
-        for(j=0; j<N; j++) {
-            y = j-Y;
-            B[i][j] = 0;
-            for(k=0; k<m; k++) {// integration wrt theta
-                theta = k*dth;
-                r1 = x*cos(theta) + y*sin(theta);
-                B[i][j] += interp(r1,r,f[k],0);
-            }
-            B[i][j] /= m;
+    Vec<T>& cth(ws.c);
+    Vec<T>& sth(ws.s);
+    Mat<T>& f(ws.f);
+    cth.SetLength(m);
+    sth.SetLength(m);
+    f.SetDims(m,n);
+    parallel_for(m, [&](int k0, int k1) {
+        for(int k=k0; k<k1; k++) {
+            cth[k] = cos(k*dth)/dr;
+            sth[k] = sin(k*dth)/dr;
+            for(int i=0; i<n; i++) f[k][i] = A[i][k];
         }
+    });
+    parallel_for(M, [&](int i0, int i1) {
+        int i,j,k,k1,kb(32);
+        for(i=i0; i<i1; i++)
+            for(j=0; j<N; j++) B[i][j] = 0;
+        for(k1=0; k1<m; k1+=kb)// block of directions
+            for(i=i0; i<i1; i++)
+                for(k=k1; k<m && k<k1+kb; k++)
+                    BackProject(B[i], f[k], n,
+                                T((g.i0 + i*g.pitch - X)*cth[k] - Y*sth[k] + R/dr),
+                                sth[k], &y[0], N);
+        for(i=i0; i<i1; i++)
+            for(j=0; j<N; j++) B[i][j] /= m;
+    });
+}
+
+template<class T>
+void BackProject(T *b, const T *a, int n, T x, T s, const T *y, int N)
+// b[j] += a interpolated linearly at t = x + y[j]*s (0<=j<N)
+//   where a = projection of n X-rays (t in units of dr);
+//   row of BackScan for one direction (also used by Accumulator)
+// t within rounding of 0 or n-1 (rays at r=-R or R) is kept
+{
+    int j,l;
+    T t,u,t1(n-1);
+    T e(16*std::numeric_limits<T>::epsilon()*t1);// rounding of t
+    for(j=0; j<N; j++) {
+        t = x + y[j]*s;
+        if(t<-e || t>t1+e) continue;
+        if(t<0) t=0;
+        else if(t>t1) t=t1;
+        l = int(t);
+        if(l==n-1) l--;
+        u = t-l;
+        b[j] += (1-u)*a[l] + u*a[l+1];
     }
 }
 
-void reconstruct(Mat_DP& B, const Mat_DP& A)
+template<class T>
+void reconstruct(Mat<T>& B, const Mat<T>& A, int window, double cutoff)
+{
+    Workspace<T> ws;
+    reconstruct(B,A,ws,window,cutoff);
+}
+
+template<class T>
+void reconstruct(Mat<T>& B, const Mat<T>& A, Workspace<T>& ws,
+                 int window, double cutoff)
 {
-    Mat_DP C;
-    filtering(C,A);
-    BackScan(B,C);
+    filtering(ws.g,A,window,cutoff);
+    BackScan(B,ws.g,ws);
 }
+
+template<class T>
+void reconstruct(Mat<T>& B, const Mat<T>& A, const Region& g,
+                 Workspace<T>& ws, int window, double cutoff)
+// region g of reconstruct(B,A) (see BackScan above)
+{
+    filtering(ws.g,A,window,cutoff);
+    BackScan(B,ws.g,g,ws);
+}
+
+template void scan(Mat_SP&, const Mat_SP&);
+template void scan(Mat_DP&, const Mat_DP&);
+template void scan(Mat_SP&, const Mat_SP&, int);
+template void scan(Mat_DP&, const Mat_DP&, int);
+template void filtering(Mat_SP&, const Mat_SP&, int, double);
+template void filtering(Mat_DP&, const Mat_DP&, int, double);
+template void filtering(Mat_SP&, const Mat_SP&, const FFT<float>&, const Filter<float>&);
+template void filtering(Mat_DP&, const Mat_DP&, const FFT<double>&, const Filter<double>&);
+template void filtering(float*, int, const float*, int, int, int,
+                        const FFT<float>&, const Filter<float>&);
+template void filtering(double*, int, const double*, int, int, int,
+                        const FFT<double>&, const Filter<double>&);
+template void BackProject(float*, const float*, int, float, float, const float*, int);
+template void BackProject(double*, const double*, int, double, double, const double*, int);
+template void BackScan(Mat_SP&, const Mat_SP&);
+template void BackScan(Mat_DP&, const Mat_DP&);
+template void BackScan(Mat_SP&, const Mat_SP&, Workspace<float>&);
+template void BackScan(Mat_DP&, const Mat_DP&, Workspace<double>&);
+template void BackScan(Mat_SP&, const Mat_SP&, const Region&, Workspace<float>&);
+template void BackScan(Mat_DP&, const Mat_DP&, const Region&, Workspace<double>&);
+template void reconstruct(Mat_SP&, const Mat_SP&, int, double);
+template void reconstruct(Mat_DP&, const Mat_DP&, int, double);
+template void reconstruct(Mat_SP&, const Mat_SP&, Workspace<float>&, int, double);
+template void reconstruct(Mat_DP&, const Mat_DP&, Workspace<double>&, int, double);
+template void reconstruct(Mat_SP&, const Mat_SP&, const Region&, Workspace<float>&, int, double);
+template void reconstruct(Mat_DP&, const Mat_DP&, const Region&, Workspace<double>&, int, double);
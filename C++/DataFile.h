@@ -0,0 +1,62 @@
+#ifndef __DataFile_h__
+#define __DataFile_h__
+
+#include "Mat.h"
+#include<cstdint>
+
+// binary file of 2D slices (images or sinograms) of same shape,
+//   mapped into memory so that slices are read without copy
+// layout (in byte order of the machine that wrote it):
+//   DataHeader, angle table (double[angles]), zero padding,
+//   slice k at offset data + k*rows*cols*dtype (data is
+//   a multiple of DataPage) with rows stored contiguously
+
+const char DataMagic[8] = "CT-DATA";
+const int DataVersion(1);
+const int DataOrder(0x01020304);
+const long DataPage(4096);
+
+enum { DATA_FLOAT=4, DATA_DOUBLE=8 };// dtype = bytes per element
+
+struct DataHeader {
+    char magic[8];     // DataMagic
+    int32_t version;   // DataVersion
+    int32_t order;     // DataOrder
+    int32_t dtype;     // DATA_FLOAT or DATA_DOUBLE
+    int32_t rows, cols;// shape of slice
+    int32_t angles;    // length of angle table
+    int64_t slices;    // number of slices
+    int64_t data;      // offset of slice 0 in bytes
+    double spacing;    // distance between X-rays (or pixels)
+};
+
+class DataFile {
+private:
+    int fd;
+    bool writable;
+    char *p;      // mapped file
+    long len;     // length of mapping in bytes
+    DataHeader *h;
+    void map(long);
+    long bytes() const;// of a slice
+public:
+    DataFile();
+    ~DataFile();
+    DataFile(const DataFile&) = delete;
+    DataFile& operator=(const DataFile&) = delete;
+    void create(const char*, int, int, int, double=1, const double* =0, int=0);
+    void open(const char*, bool=false);
+    void close();
+    inline int dtype() const { return h->dtype; }
+    inline int rows() const { return h->rows; }
+    inline int cols() const { return h->cols; }
+    inline long slices() const { return h->slices; }
+    inline double spacing() const { return h->spacing; }
+    inline int angles() const { return h->angles; }
+    inline const double *angle() const { return (const double*)(h+1); }
+    template<class T> Mat<T> slice(long) const;
+    template<class T> void read(Mat<T>&, long) const;
+    template<class T> void append(const Mat<T>&);
+};
+
+#endif // __DataFile_h__
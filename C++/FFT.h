@@ -0,0 +1,47 @@
+#ifndef __FFT_h__
+#define __FFT_h__
+
+#include "nr.h"
+
+template<class T>
+class FFT {// plan of real FFT of length n (see FFTLength)
+private:
+    int n;
+    Vec_INT rev;// pairs of indices swapped by bit reversal
+    Vec<T> w;// twiddle factors of each stage of complex FFT
+    Vec<T> u;// twiddle factors of real FFT
+    Vec_INT fac;// radices of stages if n/2 is not power of 2
+    Vec_INT cyc;// cycles of digit reversal (mixed radix)
+    void four1(T*, int, int) const;
+    void mixed(T*, int, int) const;
+    void post(T*, int, int) const;
+public:
+    explicit FFT(int);
+    inline int size() const { return n; }
+    void forward(T*, int=1) const;
+    void inverse(T*, int=1) const;
+    inline void complex(T *data, int nb, int isign) const
+    { four1(data,nb,isign); }// complex FFT of length n/2 (four1 in NR)
+};
+
+enum { RAMP, SHEPP_LOGAN, COSINE, HAMMING, HANN };// windows
+
+template<class T>
+class Filter {// reconstruction filter for FFT of length n
+private:
+    int n,window;
+    double cutoff;
+    Vec<T> h;// frequency response (with normalization)
+public:
+    Filter(int, int, double);
+    inline int size() const { return n; }
+    inline bool is(int n1, int w, double c) const
+    { return n==n1 && window==w && cutoff==c; }
+    void apply(T*, int=1) const;
+};
+
+int FFTLength(int);
+template<class T> const FFT<T>& GetFFT(int);
+template<class T> const Filter<T>& GetFilter(int, int=RAMP, double=1);
+
+#endif // __FFT_h__
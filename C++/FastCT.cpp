@@ -6,50 +6,211 @@
 //     Proceedings of the National Academy of Sciences 103 (2006) 19249
 
 #include "Radon.h"
+#include "Butterfly.h"
 #include<cmath>
 
 static double PI4(atan(1)); // pi/4
 static double PI2(PI4*2);   // pi/2
 static double PI(PI2*2);
 
-void Radon::SetSize(int n) {
+template<class T>
+void RadonT<T>::SetSize(int n) {
     int i,n2(n*2);
     if(n&(n-1)) error("n must be power of 2");
-    for(i=0; i<4; i++) d[i].SetDims(n2,n,0.);
+    for(i=0; i<4; i++) d[i].SetDims(n2,n,T(0));
 }
 
-void scan(Mat_DP& a, int h, int y)
-// recursive Radon transform
+template<class T, class F>
+static void transpose(T *b, int lb, const T *a, int la, int m, int n, const F& f)
+// f(b[j*lb+i], a[i*la+j]) for 0<=i<m and 0<=j<n
+//   in tiles of 32*32 (la<0 flips rows of a)
+{
+    parallel_for((m+31)>>5, [&](int i0, int i1) {
+        for(int i=i0<<5; i<MIN(m,i1<<5); i+=32)
+            for(int j=0; j<n; j+=32) {
+                int k,l,k1(MIN(m,i+32)),l1(MIN(n,j+32));
+                for(l=j; l<l1; l++) {
+                    T *q(b + long(l)*lb);
+                    const T *p(a + l);
+                    for(k=i; k<k1; k++) f(q[k], p[long(k)*la]);
+                }
+            }
+    });
+}
+
+template<class T, class F>
+static void copy(T *b, int lb, const T *a, int la, int m, int n, const F& f)
+// f(b[i*lb+j], a[i*la+j]) for 0<=i<m and 0<=j<n
+{
+    parallel_for(m, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++) {
+            T *q(b + long(i)*lb);
+            const T *p(a + long(i)*la);
+            for(int j=0; j<n; j++) f(q[j], p[j]);
+        }
+    });
+}
+
+struct Put { template<class T> void operator()(T& x, T y) const { x = y; } };
+struct Add { template<class T> void operator()(T& x, T y) const { x += y; } };
+
+static const int CacheSize(1<<20);// bytes of work kept in cache
+
+template<class T>
+static int TileWidth(int n)
+// number of columns of two work planes that fit in CacheSize
+{
+    int b(2);
+    while(b<n && 2*(b<<1)*(n<<1)*int(sizeof(T)) <= CacheSize) b<<=1;
+    return MIN(b,n);
+}
+
+static inline int radix(int h, int h1)
+// radix of pass from width h toward h1: one level (2)
+//   if number of levels is odd, otherwise two levels (4)
+{
+    return __builtin_ctz(h1/h)&1 ? 2 : 4;
+}
+
+template<class T>
+static void pass(Mat<T> *w, int s, int h, int r, int u0, int u1, bool back,
+                 int j0, int j1)
+// one pass from w[s] to w[1-s] making transforms of width h
+//   from those of width h/r (r=2 or 4) for units u0<=u<u1
+//   (unit u = columns r*u to r*u+r-1 of output)
+// only columns y+j (j0<=j<j1) of each transform y are made
+{
+    int u,y,k0,k1,a,b,q(h/r);
+    for(u=u0; u<u1; u+=k1-k0) {
+        y = u/q*h;
+        k0 = u%q;
+        k1 = MIN(q, k0+u1-u);
+        a = MAX(k0, j0/r);
+        b = MIN(k1, (j1-1)/r+1);
+        if(a>=b) continue;
+        if(r==2) {
+            if(back) BackScanStep(w[1-s], w[s], h, y, a, b);
+            else ScanStep(w[1-s], w[s], h, y, a, b);
+        }
+        else if(back) BackScanStep4(w[1-s], w[s], h, y, a, b);
+        else ScanStep4(w[1-s], w[s], h, y, a, b);
+    }
+}
+
+template<class T>
+static int DRT(Mat<T> *w, bool back, int j0=0, int j1=0)
+// Radon transform (back=false) or its inverse (back=true)
+//   by bottom-up iteration over width h
 // input:
-//   a = image data (shape(2n,n))
-//   h = width of transform region
-//   y = left coordinate of the region
+//   w[0] = image data or scanned data stored
+//          column by column (shape(n,2n));
+//          for back=false, columns n<=i<2n of
+//          w[0] and w[1] must be zero
+//   w[1] = work plane
 // output:
-//   a[i,y+j] = sum_{k=0}^{h-1} a[x,y+k]
-//                for 0<=i<2n and 0<=j<h where
-//     (x,y+k) moves from (i,y) to (i-j,y+h-1)
-{
-    int i,j,k,l,m(a.ncols()+h);
-    int h1(h>>1),y1(y+h1);
-    double b[h];
-    if(h1>1) {// divide and conquer
-        scan(a,h1,y);
-        scan(a,h1,y1);
+//   w[s][j,i] = sum_{k=0}^{n-1} w[0][k,x] for 0<=i<2n, 0<=j<n
+//     (x,k) moves from (i,0) to (i-j,n-1) if back=false
+//     (x,k) moves from (i,0) to (i+j,n-1) if back=true
+//       (only i<n are meaningful)
+//   return value = s (0 or 1)
+//   if j0<j1, only w[s][j,i] for j0<=j<j1 are made;
+//     transform of width h needs columns j*h/n of
+//     those of width 2h, so that passes are pruned
+// each pass from w[s] to w[1-s] fuses two levels,
+//   and passes of width up to b are done in tiles
+//   of b columns that stay in cache
+{
+    int h,s(0),n(w[0].nrows()),b(TileWidth<T>(n));
+    if(j0>=j1) { j0=0; j1=n; }
+    auto a = [=](int h) { return j0/(n/h); };// needed columns
+    auto e = [=](int h) { return (j1-1)/(n/h)+1; };//   of width h
+    parallel_for(n/b, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int h=1,s=0,r; h<b; h*=r, s=1-s) {
+                r = radix(h,b);
+                pass(w, s, h*r, r, i*b/r, (i+1)*b/r, back, a(h*r), e(h*r));
+            }
+    });
+    for(h=1; h<b; h*=radix(h,b)) s=1-s;
+    for(h=b; h<n; h*=radix(h,n), s=1-s) {
+        int r(radix(h,n));
+        parallel_for(n/r, [&](int u0, int u1) {
+            pass(w, s, h*r, r, u0, u1, back, a(h*r), e(h*r));
+        });
     }
-    for(i=m-1; i>=0; i--) {
-        for(j=0; j<h; j++) {
-            k = j>>1; l = (j+1)>>1;
-            b[j] = a[i][y+k];
-            if(i>=l) b[j] += a[i-l][y1+k];
+    return s;
+}
+
+template<class T>
+static int AdjointDRT(Mat<T> *w)
+// transpose of DRT(w,false) by top-down iteration over
+//   width h, one level per pass
+// input: w[0] = scanned data stored column by column
+//               (shape(n,2n)), w[1] = work plane
+// output: w[s] = transpose of DRT applied to w[0],
+//   where only columns 0<=i<n of w[s] are meaningful
+//   return value = s (0 or 1)
+{
+    int h,s(0),n(w[0].nrows());
+    for(h=n; h>1; h>>=1, s=1-s) {
+        int q(h>>1);
+        parallel_for(n/2, [&](int u0, int u1) {
+            for(int u=u0,k0,k1; u<u1; u+=k1-k0) {
+                k0 = u%q;
+                k1 = MIN(q, k0+u1-u);
+                AdjointStep(w[1-s], w[s], h, u/q*h, k0, k1);
+            }
+        });
+    }
+    return s;
+}
+
+template<class T>
+void scan(RadonT<T>& d, const Mat<T>& A)
+{
+    Workspace<T> ws;
+    scan(d,A,ws);
+}
+
+template<class T>
+static void scan(T *const *d, int ld, const T *a, int la, int n, Workspace<T>& ws)
+// scan of image a[i*la+j] into d[k][i*ld+j] (0<=k<4)
+{
+    int k,s,n2(n*2),lw;
+    Mat<T> *w(ws.w);// d[k] is made column by column in w
+    for(k=0; k<2; k++) w[k].SetDims(n,n2);
+    lw = w[0].stride();
+    for(k=0; k<4; k++) {
+        switch(k) {// w[0][j,i] = d[k][i,j] before scan
+        case 0: transpose(w[0][0], lw, a, la, n, n, Put()); break;
+        case 1: copy(w[0][0], lw, a, la, n, n, Put()); break;
+        case 2: copy(w[0][0], lw, a+long(n-1)*la, -la, n, n, Put()); break;
+        case 3: transpose(w[0][0], lw, a+long(n-1)*la, -la, n, n, Put());
         }
-        for(j=0; j<h; j++) a[i][y+j] = b[j];
+        parallel_for(n, [&](int j0, int j1) {
+            for(int j=j0; j<j1; j++)
+                for(int i=n; i<n2; i++) w[0][j][i] = w[1][j][i] = 0;
+        });
+        s = DRT(w,false);
+        transpose(d[k], ld, w[s][0], lw, n, n2, Put());
     }
 }
 
-void scan(Radon& d, const Mat_DP& A)
+template<class T>
+void scan(RadonT<T>& d, const Mat<T>& A, Workspace<T>& ws)
 // d = fast Radon transform of A
 // input: A = image data (shape(n,n))
+//        ws = work planes reused between calls
 // output: d(r,theta) (shape(4,2n,n))
+//   if n is not power of 2, A is padded internally with zeros
+//   to the next power of 2 (which is then n of d); image of
+//   size A.nrows() is restored by BackScan (or reconstruct)
+//   with Region(0,0) into A of that size
+// DRT is only defined for powers of 2, so that padded sizes
+//   are accepted but not cheaper: scan, filtering and most of
+//   BackScan cost as much as for the next power of 2 (n=600
+//   as n=1024); for cost that follows n, use sinogram of
+//   FFTLength(n+1) X-rays in CT.cpp instead
 //   d[0,i,j] = sum_{y=0}^{n-1} A[x,y] (0<=theta<=45)
 //     (x,y) moves from (i,0) to (i-j,n-1)
 //   d[1,i,j] = sum_{x=0}^{n-1} A[x,y] (45<=theta<=90)
@@ -61,47 +222,97 @@ void scan(Radon& d, const Mat_DP& A)
 {
     int n(A.nrows());
     if(A.ncols()!=n) error("image must be square");
-    int i,j,k;
-    d.SetSize(n);
-    for(i=0; i<n; i++) for(j=0; j<n; j++) {
-        d[0][i][j] = A[i][j];
-        d[1][i][j] = A[j][i];
-        d[2][i][j] = A[n-1-j][i];
-        d[3][i][j] = A[n-1-i][j];
+    if(n&(n-1)) {
+        Mat<T>& B(ws.e);
+        int m(1);
+        while(m<n) m<<=1;
+        B.SetDims(m,m);
+        parallel_for(m, [&](int i0, int i1) {
+            for(int i=i0; i<i1; i++)
+                for(int j=0; j<m; j++) B[i][j] = (i<n && j<n ? A[i][j] : 0);
+        });
+        scan(d,B,ws);
+        return;
     }
-    for(k=0; k<4; k++) scan(d[k],n,0);
+    d.SetSize(n);
+    T *p[4] = {d[0][0], d[1][0], d[2][0], d[3][0]};
+    scan(p, d[0].stride(), A[0], A.stride(), n, ws);
 }
 
-void BackScan(Mat_DP& a, int h, int y)
-// recursive inverse Radon transform
-// input:
-//   a = scanned data (shape(2n,n))
-//   h = width of transform region
-//   y = left coordinate of the region
-// output:
-//   a[i,y+j] = sum_{k=0}^{h-1} a[x,y+k]
-//                for 0<=i<2n and 0<=j<h where
-//     (x,y+k) moves from (i,y) to (i+j,y+h-1)
-{
-    int i,j,k,l,m(a.nrows()-h);
-    int h1(h>>1),y1(y+h1);
-    double b[h];
-    if(h1>1) {// divide and conquer
-        BackScan(a,h1,y);
-        BackScan(a,h1,y1);
+template<class T>
+void ScanAdjoint(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws)
+// A = transpose of scan applied to d, that is,
+//   sum of A*d over lines of scan(d,A) (exactly, so that
+//   <scan(A),d> = <A,ScanAdjoint(d)> for any A and d)
+// input: d = data (shape(4,2n,n))
+//        ws = work planes reused between calls
+// output: A (shape(n,n))
+// unlike BackScan, lines are not weighted by 1/4/(n-1)
+//   and lines at multiples of 45 degrees are counted twice;
+//   used by iterative solvers (iterative.cpp)
+{
+    int k,s,n(d.size()),n2(n*2),lw,la;
+    Mat<T> *w(ws.w);
+    for(k=0; k<2; k++) w[k].SetDims(n,n2);
+    A.SetDims(n,n);
+    lw = w[0].stride();
+    la = A.stride();
+    T *a(A[0]);
+    for(k=0; k<4; k++) {
+        transpose(w[0][0], lw, d[k][0], d[k].stride(), n2, n, Put());
+        s = AdjointDRT(w);
+        const T *b(w[s][0]);
+        switch(k) {// transposes of the cases of scan
+        case 0: transpose(a, la, b, lw, n, n, Put()); break;
+        case 1: copy(a, la, b, lw, n, n, Add()); break;
+        case 2: copy(a+long(n-1)*la, -la, b, lw, n, n, Add()); break;
+        case 3: transpose(a+long(n-1)*la, -la, b, lw, n, n, Add());
+        }
     }
-    for(i=0; i<m; i++) {
-        for(j=0; j<h; j++) {
-            k = j>>1; l = (j+1)>>1;
-            b[j] = a[i][y+k] + a[i+l][y1+k];
+}
+
+template<class T>
+void BackScan(Mat<T>& A, const RadonT<T>& d)
+{
+    Workspace<T> ws;
+    BackScan(A,d,ws);
+}
+
+template<class T>
+static void BackScan(T *b, int lb, const T *const *d, int ld, int n, Workspace<T>& ws,
+                     int i0=0, int j0=0, int M=0, int N=0)
+// BackScan of d[k][i*ld+j] (0<=k<4) into image b[i*lb+j]
+// if M>0, b[i*lb+j] = image[i0+i,j0+j] for 0<=i<M, 0<=j<N
+{
+    int j,k,s,n2(n*2),lw;
+    if(M==0) { M=N=n; }
+    int c0[4] = {j0, i0, n-i0-M, j0};// columns of w needed
+    int c1[4] = {j0+N, i0+M, n-i0, j0+N};//   for each k
+    double c(0.25/(n-1));
+    Mat<T> *w(ws.w);// d[k] is inverted column by column in w
+    for(k=0; k<2; k++) w[k].SetDims(n,n2);
+    lw = w[0].stride();
+    for(k=0; k<4; k++) {
+        transpose(w[0][0], lw, d[k], ld, n2, n, Put());
+        if(k&1) for(j=0; j<n; j++)// avoid double counting rays
+            w[0][0][j] = w[0][n-1][j] = 0;
+        s = DRT(w, true, c0[k], c1[k]);
+        T *a(w[s][0]);// a[j*lw+i] = inverse of d[k] at [i,j]
+        switch(k) {// sum in the order of k
+        case 0: transpose(b, lb, a+long(j0)*lw+i0, lw, N, M, Put()); break;
+        case 1: copy(b, lb, a+long(i0)*lw+j0, lw, M, N, Add()); break;
+        case 2: copy(b, lb, a+long(n-1-i0)*lw+j0, -lw, M, N, Add()); break;
+        case 3: transpose(b+long(M-1)*lb, -lb, a+long(j0)*lw+n-i0-M, lw, N, M,
+                          [c](T& x, T y) { x = (x + y)*c; });
         }
-        for(j=0; j<h; j++) a[i][y+j] = b[j];
     }
 }
 
-void BackScan(Mat_DP& A, const Radon& d)
+template<class T>
+void BackScan(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws)
 // A = inverse fast Radon transform of d
 // input: d = scanned and filtered data (shape(4,2n,n))
+//        ws = work planes reused between calls
 // output: A = image restored from d (shape(n,n))
 //   A[i,j] = sum_{y=0}^{n-1} (
 //       d[0,x,y] (x,y) moves from (i,0) to (i+j,n-1)
@@ -110,25 +321,92 @@ void BackScan(Mat_DP& A, const Radon& d)
 //     + d[3,x,y] (x,y) moves from (i',0) to (i'+j,n-1)
 //   )/4/(n-1)    where i'=n-1-i
 {
-    int i,j,n(d.size());
-    double c(0.25/(n-1));
-    Mat_DP a[4];
-    for(i=0; i<4; i++) {
-        a[i] = d[i];
-        // avoid double counting rays
-        if(i&1) for(j=0; j<n; j++)
-            a[i][j][0] = a[i][j][n-1] = 0;
-        BackScan(a[i],n,0);
-    }
+    int n(d.size());
+    const T *p[4] = {d[0][0], d[1][0], d[2][0], d[3][0]};
     A.SetDims(n,n);
-    for(i=0; i<n; i++) for(j=0; j<n; j++)
-        A[i][j] = (a[0][i][j]
-                 + a[1][j][i]
-                 + a[2][j][n-1-i]
-                 + a[3][n-1-i][j])*c;
+    BackScan(A[0], A.stride(), p, d[0].stride(), n, ws);
+}
+
+template<class T>
+void decimate(RadonT<T>& c, const RadonT<T>& a, int f, double w)
+// c = a decimated by f times w (f = power of 2, n/f>=2)
+// image BackScan(c) of size n/f is close to averages of
+//   f by f blocks of BackScan(a) if w = 1/f, and scan(B)
+//   of such block averages B if w = 1/f^2
+// coarse line (i,j) of slope s = j/(m-1) matches fine lines
+//   at f*i + t + s*(f-1)/2 (0<=t<f) of slope j*(n-1)/(m-1);
+//   values between lines are linearly interpolated
+{
+    int j,n(a.size()),m(n/f),n2(n*2),m2(m*2);
+    if(c.size() != m) c.SetSize(m);
+    Vec_INT y0(m);
+    Vec_DP v(m),s(m);
+    for(j=0; j<m; j++) {
+        double y(j*(n-1.)/(m-1));
+        y0[j] = MIN(int(y), n-2);
+        v[j] = y - y0[j];
+        s[j] = j*(f-1)/(m-1.)/2;
+    }
+    parallel_for(m2, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int k=0; k<4; k++) {
+                const Mat<T>& b(a[k]);
+                T *p(c[k][i]);
+                for(int j=0; j<m; j++) {
+                    int l(y0[j]);
+                    double z(0);
+                    for(int t=0; t<f; t++) {
+                        double x(f*i + t + s[j]);
+                        int x0((int)x);
+                        double u(x-x0);
+                        if(x0 >= n2) break;
+                        z += (1-u)*((1-v[j])*b[x0][l] + v[j]*b[x0][l+1]);
+                        if(x0+1 < n2)
+                            z += u*((1-v[j])*b[x0+1][l] + v[j]*b[x0+1][l+1]);
+                    }
+                    p[j] = z*w;
+                }
+            }
+    });
+}
+
+template<class T>
+void BackScan(Mat<T>& A, const RadonT<T>& d, const Region& g, Workspace<T>& ws)
+// A = region of inverse fast Radon transform of d
+// input: d = scanned and filtered data (shape(4,2n,n))
+//        g = region of output in n by n image;
+//            g.i0, g.j0 must be integers if g.pitch = 1
+//        M,N = A.nrows(), A.ncols() = shape of region
+// output: A[i,j] = BackScan(d)[g.i0+i, g.j0+j]
+//   (0<=i<M, 0<=j<N), identical to the full image
+// DRT is pruned to the columns of work planes needed, so
+//   that cost scales with M (for d[1],d[2]) or N (for d[0],d[3])
+// if g.pitch = f > 1 (power of 2, n/f>=2), d is decimated by f
+//   (into ws.b) and A[i,j] is close to average of f by f block
+//   of BackScan(d) centred at (g.i0+i*f, g.j0+j*f), where
+//   g.i0-(f-1)/2 and g.j0-(f-1)/2 must be multiples of f,
+//   e.g. Region((f-1)/2., (f-1)/2., f) for whole image of
+//   size n/f; cost is O(n^2/f) for decimation and that of
+//   region of BackScan of size n/f
+{
+    int n(d.size()), M(A.nrows()), N(A.ncols());
+    int f(g.pitch);
+    if(f!=g.pitch || f<1 || (f&(f-1)) || n/f<2)
+        error("pitch of fast BackScan must be power of 2");
+    double x0((g.i0 - (f-1)/2.)/f), y0((g.j0 - (f-1)/2.)/f);
+    int i0(x0), j0(y0), m(n/f);
+    if(i0!=x0 || j0!=y0)
+        error("region of fast BackScan must be on pixels");
+    if(i0<0 || j0<0 || i0+M>m || j0+N>m || M==0 || N==0)
+        error("region out of image");
+    const RadonT<T>& c(f>1 ? ws.b : d);
+    if(f>1) decimate(ws.b, d, f, 1./f);
+    const T *p[4] = {c[0][0], c[1][0], c[2][0], c[3][0]};
+    BackScan(A[0], A.stride(), p, c[0].stride(), m, ws, i0, j0, M, N);
 }
 
-void stitch(Mat_DP& A, const Radon& d)
+template<class T>
+void stitch(Mat<T>& A, const RadonT<T>& d)
 //   /|\   /|\
 //  / | \ / | \
 // |  |  |  |  |
@@ -137,50 +415,63 @@ void stitch(Mat_DP& A, const Radon& d)
 // |/   \|/   \|
 // 0 45 90 135 180
 {
-    int i,j,k,n(d.size()),n2(n*2),n4(n*4);
+    int n(d.size()),n2(n*2),n4(n*4);
     A.SetDims(n2,n4,0.);
-    for(j=0; j<n; j++) {
-        k = (n-j)>>1;
-        for(i=0; i<n2-k; i++) {
-            A[i+k][j]      = d[0][i][j];
-            A[i+k][n2-1-j] = d[1][i][j];
-            A[i+k][n2+j]   = d[2][i][j];
-            A[i+k][n4-1-j] = d[3][i][j];
+    parallel_for(n, [&](int j0, int j1) {
+        for(int j=j0; j<j1; j++) {
+            int k((n-j)>>1);
+            for(int i=0; i<n2-k; i++) {
+                A[i+k][j]      = d[0][i][j];
+                A[i+k][n2-1-j] = d[1][i][j];
+                A[i+k][n2+j]   = d[2][i][j];
+                A[i+k][n4-1-j] = d[3][i][j];
+            }
         }
-    }
+    });
 }
 
-void RadonFromSinogram(Radon& d, const Mat_DP& A)
+template<class T>
+void RadonFromSinogram(RadonT<T>& d, const Mat<T>& A)
 // input: A = output of scan() in CT.cpp
 //        n = d.size() = image size
 //        if n==0, n is set to A.nrows()/2
 // output: d = input to BackScan() in FastCT.cpp
 {
     if(d.size()==0) d.SetSize(A.nrows()/2);
-    int i,j,n(d.size()),n2(n*2);
+    int i,n(d.size()),n2(n*2);
     int N(A.nrows()), M(A.ncols());
     double n1(n-1), R(n1/sqrt(2));
     double dr(2*R/(N-1)), dth(PI/M);
-    double r1,th1,cth,jn;
-    Vec_DP r(N),th(M);
-    for(i=0; i<N; i++) r[i] = i*dr - R;
-    for(i=0; i<M; i++) th[i] = i*dth;
-    for(j=0; j<n; j++) {
-        th1 = atan2(j,n1);// slope
-        cth = cos(th1);
-        jn = (j+n1)/2;
-        for(i=0; i<n2; i++) {
-            r1 = (i - jn)*cth;// transverse coordinate
-            d[0][i][j] = interp2d(r1,th1,    r,th,A,0)*cth;
-            d[1][i][j] = interp2d(r1,PI2-th1,r,th,A,0)*cth;
-            d[2][i][j] = interp2d(r1,PI2+th1,r,th,A,0)*cth;
-            d[3][i][j] = interp2d(r1,PI-th1, r,th,A,0)*cth;
+    Grid r(-R,dr,N), th(0,dth,M);
+    parallel_for(n, [&](int j0, int j1) {
+        int i,j,k;
+        double th1,cth,jn,th2[4];
+        thread_local Vec_DP r1,t;// scratch reused by each thread
+        thread_local Vec<T> z;
+        if(r1.size() < n2) r1.SetLength(n2);
+        if(t.size() < n2) t.SetLength(n2);
+        if(z.size() < n2) z.SetLength(n2);
+        for(j=j0; j<j1; j++) {
+            th1 = atan2(j,n1);// slope
+            cth = cos(th1);
+            jn = (j+n1)/2;
+            th2[0] = th1;
+            th2[1] = PI2-th1;
+            th2[2] = PI2+th1;
+            th2[3] = PI-th1;
+            for(i=0; i<n2; i++) r1[i] = (i - jn)*cth;// transverse coordinate
+            for(k=0; k<4; k++) {
+                t = th2[k];
+                interp2d(&z[0], &r1[0], &t[0], n2, r, th, A, 0);
+                for(i=0; i<n2; i++) d[k][i][j] = z[i]*cth;
+            }
         }
-    }
+    });
     for(i=0; i<n; i++) d[3][i][0] = d[0][n-1-i][0];
 }
 
-void SinogramFromRadon(Mat_DP& A, const Radon& d)
+template<class T>
+void SinogramFromRadon(Mat<T>& A, const RadonT<T>& d)
 // input:
 //   d = output of scan() in FastCT.cpp
 //   N = A.nrows() = number of parallel X-rays
@@ -190,51 +481,205 @@ void SinogramFromRadon(Mat_DP& A, const Radon& d)
 {
     int n(d.size());
     if(A.nrows()==0) A.SetDims(n<<1, n<<2);
-    int i,j,k,n2(n*2);
+    int n2(n*2);
     int N(A.nrows()),M(A.ncols());
     double n1(n-1), R((n1)/sqrt(2));
     double dr(2*R/(N-1)), dth(PI/M);
-    double th,x1,y1,sc,yn;
-    Vec_DP x(n2),y(n);
-    for(i=0; i<n2; i++) x[i] = i;
-    for(j=0; j<n; j++) y[j] = j;
-    for(j=0; j<M; j++) {
-        th = j*dth;
-        k = int(floor(th/PI4));// 0,1,2,3
-        th = (th - PI2*(k+1>>1))*(k&1 ? -1:1);
-        y1 = n1*tan(th);
-        yn = (y1+n1)/2;
-        sc = 1/cos(th);
-        for(i=0; i<N; i++) {
-            x1 = (i*dr - R)*sc + yn;
-            A[i][j] = interp2d(x1,y1,x,y,d[k],0)*sc;
+    Grid x(0,1,n2), y(0,1,n);
+    parallel_for(M, [&](int j0, int j1) {
+        int i,j,k;
+        double th,sc,yn;
+        thread_local Vec_DP x1,y1;// scratch reused by each thread
+        thread_local Vec<T> z;
+        if(x1.size() < N) x1.SetLength(N);
+        if(y1.size() < N) y1.SetLength(N);
+        if(z.size() < N) z.SetLength(N);
+        for(j=j0; j<j1; j++) {
+            th = j*dth;
+            k = int(floor(th/PI4));// 0,1,2,3
+            th = (th - PI2*(k+1>>1))*(k&1 ? -1:1);
+            y1 = n1*tan(th);
+            yn = (y1[0]+n1)/2;
+            sc = 1/cos(th);
+            for(i=0; i<N; i++) x1[i] = (i*dr - R)*sc + yn;
+            interp2d(&z[0], &x1[0], &y1[0], N, x, y, d[k], 0);
+            for(i=0; i<N; i++) A[i][j] = z[i]*sc;
         }
-    }
+    });
 }
 
-void filtering(Radon& b, const Radon& a)
+template<class T>
+void filtering(RadonT<T>& b, const RadonT<T>& a, int window, double cutoff)
 // b = high-pass filter applied to a
 // &b==&a is allowed
+// window, cutoff = see Filter in fft.cpp
 {
     int n(a.size());
     if(b.size() != n) b.SetSize(n);
-    int i,j,k,n2(n*2);
-    double c(PI/n2),c2(1./n);
-    Vec_DP v(n2);
-    for(k=0; k<4; k++) for(j=0; j<n; j++) {
-        for(i=0; i<n2; i++) v[i] = a[k][i][j];
-        realft(v,1);// FFT
-        v[0] = 0;
-        v[1] *= PI2;
-        for(i=2; i<n2; i++) v[i] *= (i>>1)*c;
-        realft(v,-1);// inverse FFT
-        for(i=0; i<n2; i++) b[k][i][j] = v[i]*c2;
+    for(int k=0; k<4; k++) filtering(b[k], a[k], window, cutoff);
+}
+
+template<class T>
+void reconstruct(Mat<T>& A, const RadonT<T>& d, int window, double cutoff)
+{
+    Workspace<T> ws;
+    reconstruct(A,d,ws,window,cutoff);
+}
+
+template<class T>
+void reconstruct(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws,
+                 int window, double cutoff)
+{
+    filtering(ws.a,d,window,cutoff);
+    BackScan(A,ws.a,ws);
+}
+
+template<class T>
+void reconstruct(Mat<T>& A, const RadonT<T>& d, const Region& g,
+                 Workspace<T>& ws, int window, double cutoff)
+// region g of reconstruct(A,d) (see BackScan above)
+{
+    filtering(ws.a,d,window,cutoff);
+    BackScan(A,ws.a,g,ws);
+}
+
+template<class T>
+void RadonStack<T>::SetSize(int n, int S) {
+    int i,n2(n*2);
+    long j,l(long(S)*n2*n);
+    if(n&(n-1)) error("n must be power of 2");
+    for(i=0; i<4; i++) {
+        d[i].SetDims(S,n2,n);
+        for(j=0; j<l; j++) d[i].data()[j] = 0;
     }
 }
 
-void reconstruct(Mat_DP& A, const Radon& d)
+template<class T, class F>
+static void slices(int S, const F& f)
+// f(r,ws) for slices 0<=r<S with work space ws reused by
+//   slices of each thread and freed on return
+// if S>=NumThreads(), slices are shared among threads
+//   and transforms of each slice run serially; otherwise
+//   slices are done in turn by all threads
+// slices are not interleaved within rows of work planes,
+//   since cache tiles of DRT would shrink by S (10-50% slower);
+//   hence no work is shared between slices, and stack is
+//   5-30% slower than calls slice by slice into one RadonT,
+//   since all Radon data of stack pass through memory
+{
+    if(S >= NumThreads())
+        parallel_for(S, [&](int r0, int r1) {
+            Workspace<T> ws;
+            for(int r=r0; r<r1; r++) f(r, ws);
+        });
+    else {
+        Workspace<T> ws;
+        for(int r=0; r<S; r++) f(r, ws);
+    }
+}
+
+template<class T>
+void scan(RadonStack<T>& d, const Mat3D<T>& A)
+// d[k][r] = scan of slice A[r] (see scan(RadonT&, const Mat&))
+// input: A = image data (shape(S,n,n))
+// output: d (shape(4,S,2n,n))
+{
+    int S(A.dim1()),n(A.dim2());
+    if(A.dim3()!=n) error("image must be square");
+    d.SetSize(n,S);
+    slices<T>(S, [&](int r, Workspace<T>& ws) {
+        T *p[4] = {d[0][r][0], d[1][r][0], d[2][r][0], d[3][r][0]};
+        scan(p, n, A[r][0], n, n, ws);
+    });
+}
+
+template<class T>
+void BackScan(Mat3D<T>& A, const RadonStack<T>& d)
+// A[r] = BackScan of d[.][r] (see BackScan(Mat&, const RadonT&))
+// input: d = scanned and filtered data (shape(4,S,2n,n))
+// output: A = images (shape(S,n,n))
+{
+    int S(d.slices()),n(d.size());
+    A.SetDims(S,n,n);
+    slices<T>(S, [&](int r, Workspace<T>& ws) {
+        const T *p[4] = {d[0][r][0], d[1][r][0], d[2][r][0], d[3][r][0]};
+        BackScan(A[r][0], n, p, n, n, ws);
+    });
+}
+
+template<class T>
+void filtering(RadonStack<T>& b, const RadonStack<T>& a, int window, double cutoff)
+// b = high-pass filter applied to every slice of a
+// &b==&a is allowed
+// window, cutoff = see Filter in fft.cpp
 {
-    Radon a;
-    filtering(a,d);
-    BackScan(A,a);
-}
\ No newline at end of file
+    int S(a.slices()),n(a.size()),n2(n*2);
+    if(b.size() != n || b.slices() != S) b.SetSize(n,S);
+    const FFT<T>& F(GetFFT<T>(n2));
+    const Filter<T>& H(GetFilter<T>(n2,window,cutoff));
+    slices<T>(S, [&](int r, Workspace<T>&) {
+        for(int k=0; k<4; k++)
+            filtering(b[k][r][0], n, a[k][r][0], n, n2, n, F, H);
+    });
+}
+
+template<class T>
+void reconstruct(Mat3D<T>& A, const RadonStack<T>& d, int window, double cutoff)
+// A[r] = reconstruct of d[.][r] for each slice r;
+//   each slice is filtered into work space of thread
+//   and restored at once while it stays in cache
+{
+    int S(d.slices()),n(d.size()),n2(n*2);
+    const FFT<T>& F(GetFFT<T>(n2));
+    const Filter<T>& H(GetFilter<T>(n2,window,cutoff));
+    A.SetDims(S,n,n);
+    slices<T>(S, [&](int r, Workspace<T>& ws) {
+        RadonT<T>& a(ws.a);
+        if(a.size() != n) a.SetSize(n);
+        for(int k=0; k<4; k++)
+            filtering(a[k][0], a[k].stride(), d[k][r][0], n, n2, n, F, H);
+        const T *p[4] = {a[0][0], a[1][0], a[2][0], a[3][0]};
+        BackScan(A[r][0], n, p, a[0].stride(), n, ws);
+    });
+}
+
+template struct RadonT<float>;
+template struct RadonT<double>;
+template void scan(Radon_SP&, const Mat_SP&);
+template void scan(Radon&, const Mat_DP&);
+template void scan(Radon_SP&, const Mat_SP&, Workspace<float>&);
+template void scan(Radon&, const Mat_DP&, Workspace<double>&);
+template void ScanAdjoint(Mat_SP&, const Radon_SP&, Workspace<float>&);
+template void ScanAdjoint(Mat_DP&, const Radon&, Workspace<double>&);
+template void BackScan(Mat_SP&, const Radon_SP&);
+template void BackScan(Mat_DP&, const Radon&);
+template void BackScan(Mat_SP&, const Radon_SP&, Workspace<float>&);
+template void BackScan(Mat_DP&, const Radon&, Workspace<double>&);
+template void BackScan(Mat_SP&, const Radon_SP&, const Region&, Workspace<float>&);
+template void BackScan(Mat_DP&, const Radon&, const Region&, Workspace<double>&);
+template void decimate(Radon_SP&, const Radon_SP&, int, double);
+template void decimate(Radon&, const Radon&, int, double);
+template void stitch(Mat_SP&, const Radon_SP&);
+template void stitch(Mat_DP&, const Radon&);
+template void RadonFromSinogram(Radon_SP&, const Mat_SP&);
+template void RadonFromSinogram(Radon&, const Mat_DP&);
+template void SinogramFromRadon(Mat_SP&, const Radon_SP&);
+template void SinogramFromRadon(Mat_DP&, const Radon&);
+template void filtering(Radon_SP&, const Radon_SP&, int, double);
+template void filtering(Radon&, const Radon&, int, double);
+template void reconstruct(Mat_SP&, const Radon_SP&, int, double);
+template void reconstruct(Mat_DP&, const Radon&, int, double);
+template void reconstruct(Mat_SP&, const Radon_SP&, Workspace<float>&, int, double);
+template void reconstruct(Mat_DP&, const Radon&, Workspace<double>&, int, double);
+template void reconstruct(Mat_SP&, const Radon_SP&, const Region&, Workspace<float>&, int, double);
+template void reconstruct(Mat_DP&, const Radon&, const Region&, Workspace<double>&, int, double);
+template struct RadonStack<float>;
+template struct RadonStack<double>;
+template void scan(RadonStack<float>&, const Mat3D_SP&);
+template void scan(RadonStack<double>&, const Mat3D_DP&);
+template void BackScan(Mat3D_SP&, const RadonStack<float>&);
+template void BackScan(Mat3D_DP&, const RadonStack<double>&);
+template void filtering(RadonStack<float>&, const RadonStack<float>&, int, double);
+template void filtering(RadonStack<double>&, const RadonStack<double>&, int, double);
+template void reconstruct(Mat3D_SP&, const RadonStack<float>&, int, double);
+template void reconstruct(Mat3D_DP&, const RadonStack<double>&, int, double);
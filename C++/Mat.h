@@ -3,63 +3,79 @@
 #ifndef __Mat_h__
 #define __Mat_h__
 
+#include "Alloc.h"
+
+// rows are stored contiguously in one buffer aligned on Alignment bytes;
+// row i starts at data() + i*stride(), and stride() >= ncols()
+//   is padded so that every row is aligned as well
+// a view refers to external array (e.g. mapped file) which is not freed;
+//   SetDims to other dimensions makes it own a new buffer
+
 template <class T>
 class Mat {
 private:
     int nn;
     int mm;
-    T **v;
+    int ld;    // stride between rows
+    T *v;
+    bool own;  // v is freed by Mat
 public:
     Mat();
+    Mat(T *p, int n, int m, int ld);    // view of array p (shape(n,m))
     Mat(const Mat &rhs);        // Copy constructor
+    Mat(Mat &&rhs) noexcept;    // Move constructor (rhs becomes empty)
     Mat & operator=(const Mat &rhs);    //assignment
+    Mat & operator=(Mat &&rhs) noexcept;    //move assignment
     Mat & operator=(const T &a);        //assign a to every element
     inline void SetDims(int n, int m);
     inline void SetDims(int n, int m, const T& a);
     inline T* operator[](const int i);    //subscripting: pointer to row i
     inline const T* operator[](const int i) const;
+    inline T* data();
+    inline const T* data() const;
     inline int nrows() const;
     inline int ncols() const;
+    inline int stride() const;
     ~Mat();
 };
 
 template <class T>
-Mat<T>::Mat() : nn(0), mm(0), v(0) {}
+Mat<T>::Mat() : nn(0), mm(0), ld(0), v(0), own(true) {}
+
+template <class T>
+Mat<T>::Mat(T *p, int n, int m, int l) : nn(n), mm(m), ld(l), v(p), own(false) {}
 
 template <class T>
 inline void Mat<T>::SetDims(int n, int m)
+// contents are undefined unless dimensions are unchanged
 {
-    if(n==nn || m==mm) return;
-    if (v != 0) {
-        delete[] (v[0]);
-        delete[] (v);
-    }
-    nn=n; mm=m;
-    v = new T*[n];
-    v[0] = new T[m*n];
-    for (int i=1; i< n; i++)
-        v[i] = v[i-1] + m;
+    if(n==nn && m==mm) return;
+    if(own) AlignedFree(v);
+    nn=n; mm=m; ld=AlignedLength<T>(m);
+    v = AlignedAlloc<T>(long(n)*ld);
+    own = true;
 }
 
 template <class T>
 inline void Mat<T>::SetDims(int n, int m, const T& a)
 {
     SetDims(n,m);
-    for (int i=0; i<n; i++)
-        for (int j=0; j<m; j++)
-            v[i][j] = a;
+    *this = a;
+}
+
+template <class T>
+Mat<T>::Mat(const Mat &rhs) : nn(0), mm(0), ld(0), v(0), own(true)
+{
+    *this = rhs;
 }
 
 template <class T>
-Mat<T>::Mat(const Mat &rhs) : nn(rhs.nn), mm(rhs.mm), v(new T*[nn])
+Mat<T>::Mat(Mat &&rhs) noexcept
+    : nn(rhs.nn), mm(rhs.mm), ld(rhs.ld), v(rhs.v), own(rhs.own)
 {
-    int i,j;
-    v[0] = new T[mm*nn];
-    for (i=1; i< nn; i++)
-        v[i] = v[i-1] + mm;
-    for (i=0; i< nn; i++)
-        for (j=0; j<mm; j++)
-            v[i][j] = rhs[i][j];
+    rhs.nn = rhs.mm = rhs.ld = 0;
+    rhs.v = 0;
+    rhs.own = true;
 }
 
 template <class T>
@@ -71,32 +87,60 @@ Mat<T> & Mat<T>::operator=(const Mat<T> &rhs)
     if (this != &rhs) {
         int i,j;
         SetDims(rhs.nn, rhs.mm);
-        for (i=0; i< nn; i++)
-            for (j=0; j<mm; j++)
-                v[i][j] = rhs[i][j];
+        for (i=0; i< nn; i++) {
+            T *p((*this)[i]);
+            const T *q(rhs[i]);
+            for (j=0; j<mm; j++) p[j] = q[j];
+        }
     }
     return *this;
 }
 
+template <class T>
+Mat<T> & Mat<T>::operator=(Mat<T> &&rhs) noexcept
+// postcondition: buffers of matrix and rhs are exchanged
+{
+    int t;
+    t=nn; nn=rhs.nn; rhs.nn=t;
+    t=mm; mm=rhs.mm; rhs.mm=t;
+    t=ld; ld=rhs.ld; rhs.ld=t;
+    T *p(v); v=rhs.v; rhs.v=p;
+    bool o(own); own=rhs.own; rhs.own=o;
+    return *this;
+}
+
 template <class T>
 Mat<T> & Mat<T>::operator=(const T &a)    //assign a to every element
 {
-    for (int i=0; i< nn; i++)
-        for (int j=0; j<mm; j++)
-            v[i][j] = a;
+    for (int i=0; i< nn; i++) {
+        T *p((*this)[i]);
+        for (int j=0; j<mm; j++) p[j] = a;
+    }
     return *this;
 }
 
 template <class T>
 inline T* Mat<T>::operator[](const int i)    //subscripting: pointer to row i
 {
-    return v[i];
+    return v + long(i)*ld;
 }
 
 template <class T>
 inline const T* Mat<T>::operator[](const int i) const
 {
-    return v[i];
+    return v + long(i)*ld;
+}
+
+template <class T>
+inline T* Mat<T>::data()
+{
+    return v;
+}
+
+template <class T>
+inline const T* Mat<T>::data() const
+{
+    return v;
 }
 
 template <class T>
@@ -111,15 +155,20 @@ inline int Mat<T>::ncols() const
     return mm;
 }
 
+template <class T>
+inline int Mat<T>::stride() const
+{
+    return ld;
+}
+
 template <class T>
 Mat<T>::~Mat()
 {
-    if (v != 0) {
-        delete[] (v[0]);
-        delete[] (v);
-    }
+    if(own) AlignedFree(v);
 }
 
+typedef Mat<float> Mat_SP, Mat_O_SP, Mat_IO_SP;
+typedef const Mat<float> Mat_I_SP;
 typedef Mat<double> Mat_DP, Mat_O_DP, Mat_IO_DP;
 typedef Mat<int> Mat_INT, Mat_O_INT, Mat_IO_INT;
 typedef const Mat<double> Mat_I_DP;
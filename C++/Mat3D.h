@@ -3,18 +3,37 @@
 #ifndef __Mat3D_h__
 #define __Mat3D_h__
 
+#include "Alloc.h"
+
+// elements are stored contiguously in one aligned buffer:
+//   M[i][j][k] = data()[(i*dim2() + j)*dim3() + k]
+
 template <class T>
 class Mat3D {
 private:
     int nn;
     int mm;
     int kk;
-    T ***v;
+    T *v;
 public:
+    template <class U>
+    class Slice {// plane i of M, indexed by j
+        U *p;
+        int k;
+    public:
+        Slice(U *p, int k) : p(p), k(k) {}
+        U* operator[](const int j) const { return p + long(j)*k; }
+    };
     Mat3D();
+    Mat3D(const Mat3D &rhs);    // Copy constructor
+    Mat3D(Mat3D &&rhs) noexcept;    // Move constructor (rhs becomes empty)
+    Mat3D & operator=(const Mat3D &rhs);    //assignment
+    Mat3D & operator=(Mat3D &&rhs) noexcept;    //move assignment
     inline void SetDims(int n, int m, int k);
-    inline T** operator[](const int i);	//subscripting: pointer to row i
-    inline const T* const * operator[](const int i) const;
+    inline Slice<T> operator[](const int i);	//subscripting: plane i
+    inline Slice<const T> operator[](const int i) const;
+    inline T* data();
+    inline const T* data() const;
     inline int dim1() const;
     inline int dim2() const;
     inline int dim3() const;
@@ -28,36 +47,72 @@ template <class T>
 inline void Mat3D<T>::SetDims(int n, int m, int k)
 {
     if(n==nn && m==mm && k==kk) return;
-    int i,j;
-    if (v != 0) {
-        delete[] (v[0][0]);
-        delete[] (v[0]);
-        delete[] (v);
-    }
+    AlignedFree(v);
     nn=n; mm=m; kk=k;
-    v = new T**[n];
-    v[0] = new T*[n*m];
-    v[0][0] = new T[n*m*k];
-    for(j=1; j<m; j++)
-        v[0][j] = v[0][j-1] + k;
-    for(i=1; i<n; i++) {
-        v[i] = v[i-1] + m;
-        v[i][0] = v[i-1][0] + m*k;
-        for(j=1; j<m; j++)
-            v[i][j] = v[i][j-1] + k;
+    v = AlignedAlloc<T>(long(n)*m*k);
+}
+
+template <class T>
+Mat3D<T>::Mat3D(const Mat3D &rhs) : nn(0), mm(0), kk(0), v(0)
+{
+    *this = rhs;
+}
+
+template <class T>
+Mat3D<T>::Mat3D(Mat3D &&rhs) noexcept
+    : nn(rhs.nn), mm(rhs.mm), kk(rhs.kk), v(rhs.v)
+{
+    rhs.nn = rhs.mm = rhs.kk = 0;
+    rhs.v = 0;
+}
+
+template <class T>
+Mat3D<T> & Mat3D<T>::operator=(const Mat3D<T> &rhs)
+{
+    if (this != &rhs) {
+        SetDims(rhs.nn, rhs.mm, rhs.kk);
+        long i,l(long(nn)*mm*kk);
+        for (i=0; i<l; i++) v[i] = rhs.v[i];
     }
+    return *this;
+}
+
+template <class T>
+Mat3D<T> & Mat3D<T>::operator=(Mat3D<T> &&rhs) noexcept
+// postcondition: buffers of M and rhs are exchanged
+{
+    int t;
+    t=nn; nn=rhs.nn; rhs.nn=t;
+    t=mm; mm=rhs.mm; rhs.mm=t;
+    t=kk; kk=rhs.kk; rhs.kk=t;
+    T *p(v); v=rhs.v; rhs.v=p;
+    return *this;
+}
+
+template <class T>
+inline typename Mat3D<T>::template Slice<T>
+Mat3D<T>::operator[](const int i) //subscripting: plane i
+{
+    return Slice<T>(v + long(i)*mm*kk, kk);
 }
 
 template <class T>
-inline T** Mat3D<T>::operator[](const int i) //subscripting: pointer to row i
+inline typename Mat3D<T>::template Slice<const T>
+Mat3D<T>::operator[](const int i) const
 {
-    return v[i];
+    return Slice<const T>(v + long(i)*mm*kk, kk);
 }
 
 template <class T>
-inline const T* const * Mat3D<T>::operator[](const int i) const
+inline T* Mat3D<T>::data()
 {
-    return v[i];
+    return v;
+}
+
+template <class T>
+inline const T* Mat3D<T>::data() const
+{
+    return v;
 }
 
 template <class T>
@@ -81,13 +136,11 @@ inline int Mat3D<T>::dim3() const
 template <class T>
 Mat3D<T>::~Mat3D()
 {
-    if (v != 0) {
-        delete[] (v[0][0]);
-        delete[] (v[0]);
-        delete[] (v);
-    }
+    AlignedFree(v);
 }
 
+typedef Mat3D<float> Mat3D_SP, Mat3D_O_SP, Mat3D_IO_SP;
+typedef const Mat3D<float> Mat3D_I_SP;
 typedef Mat3D<double> Mat3D_DP, Mat3D_O_DP, Mat3D_IO_DP;
 typedef const Mat3D<double> Mat3D_I_DP;
 
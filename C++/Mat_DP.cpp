@@ -1,5 +1,114 @@
 #include<fstream>
+#include<cstring>
 #include "Mat_DP.h"
+#include "DataFile.h"
+#include "nr.h"
+#include "Parallel.h"
+#include<mutex>
+
+static void RowStats(const double *a, int n, double *r)
+// r[0..3] = min, max, sum, sum of squares of a[0..n-1] (n>0)
+// four partial sums are kept to expose SIMD parallelism
+{
+    int j,k;
+    double mn[4],mx[4],s[4]={0,0,0,0},q[4]={0,0,0,0};
+    for(k=0; k<4; k++) mn[k] = mx[k] = a[0];
+    for(j=0; j+4<=n; j+=4)
+        for(k=0; k<4; k++) {
+            double x(a[j+k]);
+            mn[k] = x < mn[k] ? x : mn[k];
+            mx[k] = x > mx[k] ? x : mx[k];
+            s[k] += x;
+            q[k] += x*x;
+        }
+    for(; j<n; j++) {
+        if(a[j] < mn[0]) mn[0] = a[j];
+        if(a[j] > mx[0]) mx[0] = a[j];
+        s[0] += a[j];
+        q[0] += a[j]*a[j];
+    }
+    r[0] = MIN(MIN(mn[0],mn[1]), MIN(mn[2],mn[3]));
+    r[1] = MAX(MAX(mx[0],mx[1]), MAX(mx[2],mx[3]));
+    r[2] = (s[0]+s[1]) + (s[2]+s[3]);
+    r[3] = (q[0]+q[1]) + (q[2]+q[3]);
+}
+
+static void RowHistogram(long *h, int b, const double *a, int n, double lo, double c)
+// add a[0..n-1] to h[0..b-1] of bins of width 1/c from lo
+//   elements outside range are counted in the end bins
+{
+    for(int j=0; j<n; j++) {
+        double x((a[j] - lo)*c);
+        h[x > 0 ? (x < b ? int(x) : b-1) : 0]++;
+    }
+}
+
+void stats(MatStats& S, const Mat_DP& A, int bins, double lo, double hi)
+// min, max, sum and sum of squares of A in one parallel sweep
+// bins = number of bins of histogram (none if bins=0)
+// lo,hi = range of histogram; if lo<hi, histogram is made
+//   in the same sweep, else range is [min,max] and
+//   histogram takes one more sweep
+// sums are reproducible regardless of number of threads
+{
+    int i,m(A.nrows()),n(A.ncols());
+    if(m==0 || n==0) error("stats: empty matrix");
+    Mat_DP r;
+    r.SetDims(m,4);
+    S.hist.SetLength(bins);
+    for(i=0; i<bins; i++) S.hist[i] = 0;
+    S.lo = lo;
+    S.hi = hi;
+    bool fused(bins && lo<hi);
+    std::mutex l;
+    auto sweep = [&](int i0, int i1, bool moments, bool histogram) {
+        Vec<long> h(histogram ? bins : 0);
+        double c(bins/(S.hi - S.lo));
+        for(int k=0; k<h.size(); k++) h[k] = 0;
+        for(int i=i0; i<i1; i++) {
+            if(moments) RowStats(A[i], n, r[i]);
+            if(histogram) RowHistogram(&h[0], bins, A[i], n, S.lo, c);
+        }
+        if(!histogram) return;
+        std::lock_guard<std::mutex> g(l);
+        for(int k=0; k<bins; k++) S.hist[k] += h[k];
+    };
+    parallel_for(m, [&](int i0, int i1) { sweep(i0, i1, true, fused); });
+    S.min = r[0][0];
+    S.max = r[0][1];
+    S.sum = S.sumsq = 0;
+    for(i=0; i<m; i++) {
+        if(r[i][0] < S.min) S.min = r[i][0];
+        if(r[i][1] > S.max) S.max = r[i][1];
+        S.sum += r[i][2];
+        S.sumsq += r[i][3];
+    }
+    S.count = long(m)*n;
+    if(bins && !fused) {
+        S.lo = S.min;
+        S.hi = (S.max > S.min ? S.max : S.min + 1);
+        parallel_for(m, [&](int i0, int i1) { sweep(i0, i1, false, true); });
+    }
+}
+
+double MatStats::stdev() const
+// standard deviation of elements
+{
+    double m(mean()), v(sumsq/count - m*m);
+    return v > 0 ? sqrt(v) : 0;
+}
+
+double MatStats::percentile(double p) const
+// value below which p percent of elements fall,
+//   linearly interpolated in a bin of histogram
+{
+    int k,b(hist.size());
+    if(b==0) error("percentile: no histogram");
+    double c(p/100*count), s(0), w((hi-lo)/b);
+    for(k=0; k<b-1 && s + hist[k] < c; k++) s += hist[k];
+    double x(lo + w*(k + (hist[k] ? MIN(MAX((c-s)/hist[k], 0.), 1.) : 0)));
+    return MAX(min, MIN(max, x));
+}
 
 double min(const Mat_DP& A)
 {
@@ -19,25 +128,34 @@ double max(const Mat_DP& A)
     return a;
 }
 
-void save(const char *file_name, Mat_DP& A)
+void save(const char *file_name, const Mat_DP& A)
+// write A to data file of one slice (DataFile.h)
 {
-    int i,j,m(A.nrows()),n(A.ncols());
-    std::ofstream s(file_name, std::ofstream::binary);
-    s.write((const char *)&m, sizeof(int));
-    s.write((const char *)&n, sizeof(int));
-    for(i=0; i<m; i++) for(j=0; j<n; j++)
-        s.write((const char*)&A[i][j], sizeof(double));
+    DataFile f;
+    f.create(file_name, DATA_DOUBLE, A.nrows(), A.ncols());
+    f.append(A);
 }
 
 void load(Mat_DP& A, const char *file_name)
+// read slice 0 of data file, or file written by
+//   former save() (int m,n followed by m*n doubles)
 {
-    int i,j,m,n;
+    int i,m,n;
+    char magic[sizeof(DataMagic)];
     std::ifstream s(file_name, std::ifstream::binary);
+    if(!s.read(magic, sizeof(magic))) error("load: cannot read file");
+    if(memcmp(magic, DataMagic, sizeof(magic))==0) {
+        DataFile f;
+        f.open(file_name);
+        f.read(A,0);
+        return;
+    }
+    s.seekg(0);
     s.read((char *)&m, sizeof(int));
     s.read((char *)&n, sizeof(int));
     A.SetDims(m,n);
-    for(i=0; i<m; i++) for(j=0; j<n; j++)
-        s.read((char *)&A[i][j], sizeof(double));
+    for(i=0; i<m; i++)
+        s.read((char *)A[i], n*sizeof(double));
 }
 
 void WriteBMP32(const char *file_name, const Mat_DP& A)
@@ -47,25 +165,28 @@ void WriteBMP32(const char *file_name, const Mat_DP& A)
 // i increases from top to bottom
 // j increases from left to right
 {
-    int i,j,k,m(A.nrows()),n(A.ncols());
-    double a(min(A)),b(max(A)-a);
-    Mat3D_DP B;
-    B.SetDims(m,n,3);
-    for(i=0; i<m; i++) for(j=0; j<n; j++)
-        for(k=0; k<3; k++) B[i][j][k] = (A[i][j]-a)/b;
-    WriteBMP32(file_name, B);
+    MatStats S;
+    stats(S,A);
+    WriteBMP(file_name, A, S.min, S.max - S.min, 32);
+}
+
+void WriteBMP8(const char *file_name, const Mat_DP& A)
+// same as WriteBMP32 but 8bit with gray palette
+{
+    MatStats S;
+    stats(S,A);
+    WriteBMP(file_name, A, S.min, S.max - S.min, 8);
 }
 
-void ReadBMP32(Mat_DP& A, const char *file_name, int color)
-// read matrix data A from bitmap file
-// color = 0,1,2 for R,G,B
-// A[i,j] are real value between 0 and 1
+void WriteWindowBMP(const char *file_name, const Mat_DP& A,
+                    double p0, double p1, int bits)
+// write A to gray bitmap file of bits = 8 or 32
+// window is set from percentile p0 to p1 of elements of A
+//   (black and white), so that a few outliers do not
+//   compress contrast of the rest
 {
-    int i,j;
-    Mat3D_DP B;
-    ReadBMP32(B, file_name);
-    A.SetDims(B.dim1(), B.dim2());
-    for(i=0; i<B.dim1(); i++)
-        for(j=0; j<B.dim2(); j++)
-            A[i][j] = B[i][j][color];
+    MatStats S;
+    stats(S, A, 4096);
+    double a(S.percentile(p0)), b(S.percentile(p1));
+    WriteBMP(file_name, A, a, b>a ? b-a : 1, bits);
 }
@@ -1,19 +1,36 @@
 #ifndef __Mat_DP_h__
 #define __Mat_DP_h__
 
+#include "Vec.h"
 #include "Mat.h"
 #include "Mat3D.h"
 #include<cmath>
 
+struct MatStats {// statistics of elements of a matrix
+    double min,max;
+    double sum,sumsq;// of elements and of their squares
+    long count;      // number of elements
+    double lo,hi;    // range of histogram
+    Vec<long> hist;  // number of elements in each bin of [lo,hi]
+    inline double mean() const { return sum/count; }
+    double stdev() const;
+    double percentile(double) const;
+};
+
+void stats(MatStats&, const Mat_DP&, int=0, double=0, double=0);
 double max(const Mat_DP&);
 double min(const Mat_DP&);
 
-void save(const char*, Mat_DP&);
+void save(const char*, const Mat_DP&);
 void load(Mat_DP&, const char *file_name);
 
 void WriteBMP32(const char*, const Mat_DP&);
+void WriteBMP8(const char*, const Mat_DP&);
+void WriteBMP(const char*, const Mat_DP&, double, double, int=32);
+void WriteWindowBMP(const char*, const Mat_DP&, double=1, double=99, int=8);
 void ReadBMP32(Mat_DP&, const char*, int=0);
 void WriteBMP32(const char*, const Mat3D_DP&);
 void ReadBMP32(Mat3D_DP&, const char*);
+void ReadBMP8(Mat3D_DP&, const char*);
 
 #endif // __Mat_DP_h__
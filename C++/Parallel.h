@@ -0,0 +1,21 @@
+#ifndef __Parallel_h__
+#define __Parallel_h__
+
+void SetNumThreads(int);// 0 = number of cores
+int NumThreads();
+void parallel(int, void (*)(void*, int, int), void*);
+
+template<class F>
+void parallel_call(void *f, int i0, int i1)
+{ (*(const F*)f)(i0,i1); }
+
+template<class F>
+inline void parallel_for(int n, const F& f)
+// call f(i0,i1) for disjoint ranges [i0,i1) covering [0,n)
+//   on NumThreads() threads; ranges are fixed by n and
+//   number of threads, so that results are reproducible
+// nested calls and calls while other thread is in
+//   parallel region are executed serially by caller
+{ parallel(n, parallel_call<F>, (void*)&f); }
+
+#endif // __Parallel_h__
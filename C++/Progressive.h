@@ -0,0 +1,47 @@
+#ifndef __Progressive_h__
+#define __Progressive_h__
+
+#include "Radon.h"
+
+// coarse to fine reconstruction from Radon data (FastCT.cpp)
+//   for interactive preview: images of size n/2^l are made
+//   for l = levels,...,1 and then the full image (l=0);
+//   data are filtered once at full resolution and finer
+//   coarse levels are decimated from the filtered data
+// coarse levels are made in addition to reconstruct: the full
+//   image cannot start from a coarse one, since partial sums
+//   of inverse DRT run over slopes of lines, not over blocks
+//   of image, so that pixels appear only after its last pass;
+//   what is gained is latency, not total time: level l is
+//   ready after about 4^-l of the time of reconstruct, and
+//   the total is 10-60% more than reconstruct, mostly for
+//   level 1 (see bench progressive)
+
+template<class T>
+class Progressive {
+private:
+    enum { MAX_LEVELS=4 };
+    int L;// number of coarse levels
+    int window;
+    double cutoff;
+    Workspace<T> ws[MAX_LEVELS+1];// ws[l].a = filtered data of level l
+    Mat<T> B[MAX_LEVELS+1];// images of coarse levels
+public:
+    Progressive(int=2, int=RAMP, double=1);
+    void run(Mat<T>&, const RadonT<T>&, void (*)(int, const Mat<T>&, void*), void*);
+    template<class F> inline void run(Mat<T>&, const RadonT<T>&, const F&);
+};
+
+template<class T, class F>
+void progressive_call(int l, const Mat<T>& A, void *f)
+{ (*(const F*)f)(l,A); }
+
+template<class T>
+template<class F>
+inline void Progressive<T>::run(Mat<T>& A, const RadonT<T>& d, const F& f)
+// f(l,B) = called with image B of level l (size n>>l)
+//   as soon as it is made, for l = levels,...,1,0;
+//   B of l=0 is A itself
+{ run(A, d, progressive_call<T,F>, (void*)&f); }
+
+#endif // __Progressive_h__
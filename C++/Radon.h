@@ -3,30 +3,120 @@
 
 #include "nr.h"
 #include "Mat_DP.h"
+#include "Parallel.h"
+#include "FFT.h"
 
-struct Radon {// Discrete Radon Transform
-    Mat_DP d[4];
+struct Grid {// uniform grid x[i] = x0 + i*dx (0<=i<n)
+    double x0,dx;
+    int n;
+    Grid(double a, double d, int m) : x0(a), dx(d), n(m) {}
+    inline double operator[](int i) const { return x0 + i*dx; }
+    inline int size() const { return n; }
+};
+
+struct Region {// output pixels B[i][j] at (i0+i*pitch, j0+j*pitch)
+    double i0,j0;// of full image (region of interest)
+    double pitch;// distance between output pixels (>1 to decimate)
+    int M,N;// shape of full image (both n/2 if M==0, CT.cpp only)
+    Region(double i, double j, double p=1, int m=0, int n=0)
+        : i0(i), j0(j), pitch(p), M(m), N(n) {}
+};
+
+// transforms are templates on scalar type T (float or double);
+// geometry is computed in double and data are stored in T
+
+template<class T>
+struct RadonT {// Discrete Radon Transform (n = power of 2;
+               //   scan pads images of other sizes)
+    Mat<T> d[4];
     inline int size() const { return d[0].ncols(); }
-    inline Mat_DP& operator[](int i) { return d[i]; }
-    inline const Mat_DP& operator[](int i) const { return d[i]; }
+    inline Mat<T>& operator[](int i) { return d[i]; }
+    inline const Mat<T>& operator[](int i) const { return d[i]; }
     void SetSize(int);
 };
 
-void scan(Radon&, const Mat_DP&);
-void BackScan(Mat_DP&, const Radon&);
-void reconstruct(Mat_DP&, const Radon&);
-void RadonFromSinogram(Radon&, const Mat_DP&);
-void SinogramFromRadon(Mat_DP&, const Radon&);
-void stitch(Mat_DP&, const Radon&);
-void filtering(Radon&, const Radon&);
+typedef RadonT<double> Radon;
+typedef RadonT<float> Radon_SP;
+
+template<class T>
+struct RadonStack {// Radon transforms of S slices
+    Mat3D<T> d[4];// d[k][r][i][j] = d[k][i][j] of slice r
+    inline int size() const { return d[0].dim3(); }
+    inline int slices() const { return d[0].dim1(); }
+    inline Mat3D<T>& operator[](int i) { return d[i]; }
+    inline const Mat3D<T>& operator[](int i) const { return d[i]; }
+    void SetSize(int, int);
+};
+
+template<class T>
+struct Workspace {// temporaries of transforms kept between calls
+    Mat<T> w[2];// work planes of fast Radon transform
+    Mat<T> f;// transposed sinogram (BackScan in CT.cpp)
+    Mat<T> g;// filtered sinogram (reconstruct in CT.cpp)
+    RadonT<T> a;// filtered Radon data (reconstruct in FastCT.cpp)
+    RadonT<T> b;// decimated Radon data (BackScan in FastCT.cpp)
+    Vec<T> c,s;// cos and sin of directions
+    RadonT<T> r,q;// residual and scanned direction (iterative.cpp)
+    Mat<T> u,v;// gradient and search direction (iterative.cpp)
+    Vec_DP p;// partial sums of rows (iterative.cpp)
+    Mat<T> e;// image padded to power of 2 (scan in FastCT.cpp)
+};
+// repeated calls of the same size with the same Workspace
+//   do no allocation after the first call (see Allocations
+//   in Alloc.h); functions without Workspace use a local one,
+//   and those on stacks of slices use one per thread for
+//   the duration of the call
+
+template<class T> void scan(RadonT<T>&, const Mat<T>&);
+template<class T> void scan(RadonT<T>&, const Mat<T>&, Workspace<T>&);
+template<class T> void ScanAdjoint(Mat<T>&, const RadonT<T>&, Workspace<T>&);
+template<class T> void BackScan(Mat<T>&, const RadonT<T>&);
+template<class T> void BackScan(Mat<T>&, const RadonT<T>&, Workspace<T>&);
+template<class T> void BackScan(Mat<T>&, const RadonT<T>&, const Region&, Workspace<T>&);
+template<class T> void reconstruct(Mat<T>&, const RadonT<T>&, int=RAMP, double=1);
+template<class T> void reconstruct(Mat<T>&, const RadonT<T>&, Workspace<T>&, int=RAMP, double=1);
+template<class T> void reconstruct(Mat<T>&, const RadonT<T>&, const Region&, Workspace<T>&, int=RAMP, double=1);
+template<class T> void RadonFromSinogram(RadonT<T>&, const Mat<T>&);
+template<class T> void SinogramFromRadon(Mat<T>&, const RadonT<T>&);
+template<class T> void decimate(RadonT<T>&, const RadonT<T>&, int, double=1);
+template<class T> void stitch(Mat<T>&, const RadonT<T>&);
+template<class T> void filtering(RadonT<T>&, const RadonT<T>&, int=RAMP, double=1);
+
+enum { SIRT, CGLS };// iterative solvers (iterative.cpp)
+
+template<class T> int solve(Mat<T>&, const RadonT<T>&, int=SIRT, int=20, double=1e-3, bool=true);
+template<class T> int solve(Mat<T>&, const RadonT<T>&, Workspace<T>&, int=SIRT, int=20, double=1e-3, bool=true);
+
+// stacks of S slices A[r] in Mat3D (shape(S,n,n));
+//   not faster than slice by slice calls (see FastCT.cpp)
+template<class T> void scan(RadonStack<T>&, const Mat3D<T>&);
+template<class T> void BackScan(Mat3D<T>&, const RadonStack<T>&);
+template<class T> void filtering(RadonStack<T>&, const RadonStack<T>&, int=RAMP, double=1);
+template<class T> void reconstruct(Mat3D<T>&, const RadonStack<T>&, int=RAMP, double=1);
+
+enum { SCAN_SAMPLED, SCAN_JOSEPH };// projectors of scan in CT.cpp
 
-void scan(Mat_DP&, const Mat_DP&);// slow
-void BackScan(Mat_DP&, const Mat_DP&);// slow
-void filtering(Mat_DP&, const Mat_DP&);
-void reconstruct(Mat_DP&, const Mat_DP&);// slow
+template<class T> void scan(Mat<T>&, const Mat<T>&);// slow
+template<class T> void scan(Mat<T>&, const Mat<T>&, int);
+template<class T> void BackScan(Mat<T>&, const Mat<T>&);
+template<class T> void BackScan(Mat<T>&, const Mat<T>&, Workspace<T>&);
+template<class T> void BackScan(Mat<T>&, const Mat<T>&, const Region&, Workspace<T>&);
+template<class T> void BackProject(T*, const T*, int, T, T, const T*, int);
+template<class T> void filtering(Mat<T>&, const Mat<T>&, int=RAMP, double=1);
+template<class T> void filtering(Mat<T>&, const Mat<T>&, const FFT<T>&, const Filter<T>&);
+template<class T> void filtering(T*, int, const T*, int, int, int, const FFT<T>&, const Filter<T>&);
+template<class T> void reconstruct(Mat<T>&, const Mat<T>&, int=RAMP, double=1);
+template<class T> void reconstruct(Mat<T>&, const Mat<T>&, Workspace<T>&, int=RAMP, double=1);
+template<class T> void reconstruct(Mat<T>&, const Mat<T>&, const Region&, Workspace<T>&, int=RAMP, double=1);
+template<class T> void FourierReconstruct(Mat<T>&, const Mat<T>&);
 
 double interp2d(double, double, const Vec_DP&, const Vec_DP&, const Mat_DP&, double);
 double interp(double, const Vec_DP&, const Vec_DP&, double);
-void realft(Vec_IO_DP&, const int);
+template<class T> T interp(double, const Grid&, const T*, double);
+template<class T> T interp2d(double, double, const Grid&, const Grid&, const Mat<T>&, double);
+template<class T> void interp2d(T*, const double*, const double*, int,
+                                const Grid&, const Grid&, const Mat<T>&, double);
+template<class T> void realft(Vec<T>&, const int);
+template<class T> void realft(T*, const int, const int, const int);
 
 #endif // __Radon_h__
@@ -0,0 +1,32 @@
+#ifndef __Reconstructor_h__
+#define __Reconstructor_h__
+
+#include "Radon.h"
+
+template<class T>
+class Reconstructor {// fixed geometry of fast reconstruction from sinograms
+private:
+    struct Point { int i,j; T s,t; };// stencil of bilinear interpolation
+    int n,N,M;// image size, number of X-rays and directions
+    Vec<Point> rs;// sinogram to Radon data in order of d[k][i][j]
+    Vec<Point> sr;// Radon data to sinogram in order of A[i][j]
+    Vec_DP rc;// factor of column j of Radon data
+    Vec_DP sc;// factor of direction j of sinogram
+    Vec_INT sk;// quadrant of direction j of sinogram
+    const FFT<T>& F;
+    const Filter<T>& H;
+    RadonT<T> d;
+    Workspace<T> ws;
+public:
+    Reconstructor(int, int, int, int=RAMP, double=1);
+    inline int size() const { return n; }
+    inline int rays() const { return N; }
+    inline int directions() const { return M; }
+    void RadonFromSinogram(RadonT<T>&, const Mat<T>&) const;
+    void filtering(RadonT<T>&) const;
+    void SinogramFromRadon(Mat<T>&, const RadonT<T>&) const;
+    void reconstruct(Mat<T>&, const Mat<T>&);
+    void project(Mat<T>&, const Mat<T>&);
+};
+
+#endif // __Reconstructor_h__
@@ -0,0 +1,40 @@
+#ifndef __Stream_h__
+#define __Stream_h__
+
+#include "Reconstructor.h"
+
+// pipelined reconstruction of a stream of sinograms:
+//   read -> RadonFromSinogram -> filtering -> BackScan -> write
+// each stage runs on its own thread and passes slices to the
+//   next through a bounded queue, so that time per slice is
+//   that of the slowest stage instead of the sum of all stages
+
+template<class T>
+void stream(const Reconstructor<T>&, bool (*)(Mat<T>&, void*),
+            void (*)(const Mat<T>&, void*), void*, long=0);
+
+template<class R, class W>
+struct StreamCall { const R& read; const W& write; };
+
+template<class T, class R, class W>
+bool stream_read(Mat<T>& A, void *f)
+{ return ((const StreamCall<R,W>*)f)->read(A); }
+
+template<class T, class R, class W>
+void stream_write(const Mat<T>& B, void *f)
+{ ((const StreamCall<R,W>*)f)->write(B); }
+
+template<class T, class R, class W>
+inline void stream(const Reconstructor<T>& rec,
+                   const R& read, const W& write, long budget=0)
+// read(A) = fill next sinogram A and return true,
+//           or return false at end of stream
+// write(B) = called with restored images B in order of input
+// budget = bytes of slice buffers and work planes
+//          (0 for two slices in each queue)
+{
+    StreamCall<R,W> f = {read, write};
+    stream(rec, stream_read<T,R,W>, stream_write<T,R,W>, (void*)&f, budget);
+}
+
+#endif // __Stream_h__
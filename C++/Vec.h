@@ -3,21 +3,27 @@
 #ifndef __Vec_h__
 #define __Vec_h__
 
+#include "Alloc.h"
+
 template <class T>
 class Vec {
 private:
     int nn;    // size of array. upper index is nn-1
-    T *v;
+    T *v;      // aligned on Alignment bytes
 public:
     Vec();
     explicit Vec(int n);        // Zero-based array
     Vec(const T &a, int n);    //initialize to constant value
     Vec(const T *a, int n);    // Initialize to array
     Vec(const Vec &rhs);    // Copy constructor
+    Vec(Vec &&rhs) noexcept;    // Move constructor (rhs becomes empty)
     Vec & operator=(const Vec &rhs);    //assignment
+    Vec & operator=(Vec &&rhs) noexcept;    //move assignment
     Vec & operator=(const T &a);    //assign a to every element
     inline T & operator[](const int i);    //i'th element
     inline const T & operator[](const int i) const;
+    inline T* data();
+    inline const T* data() const;
     inline int size() const;
     inline void SetLength(int);
     ~Vec();
@@ -27,36 +33,43 @@ template <class T>
 Vec<T>::Vec() : nn(0), v(0) {}
 
 template <class T>
-Vec<T>::Vec(int n) : nn(n), v(new T[n]) {}
+Vec<T>::Vec(int n) : nn(n), v(AlignedAlloc<T>(n)) {}
 
 template <class T>
-Vec<T>::Vec(const T& a, int n) : nn(n), v(new T[n])
+Vec<T>::Vec(const T& a, int n) : nn(n), v(AlignedAlloc<T>(n))
 {
     for(int i=0; i<n; i++)
         v[i] = a;
 }
 
 template <class T>
-Vec<T>::Vec(const T *a, int n) : nn(n), v(new T[n])
+Vec<T>::Vec(const T *a, int n) : nn(n), v(AlignedAlloc<T>(n))
 {
     for(int i=0; i<n; i++)
         v[i] = *a++;
 }
 
 template <class T>
-Vec<T>::Vec(const Vec<T> &rhs) : nn(rhs.nn), v(new T[nn])
+Vec<T>::Vec(const Vec<T> &rhs) : nn(rhs.nn), v(AlignedAlloc<T>(nn))
 {
     for(int i=0; i<nn; i++)
         v[i] = rhs[i];
 }
 
+template <class T>
+Vec<T>::Vec(Vec<T> &&rhs) noexcept : nn(rhs.nn), v(rhs.v)
+{
+    rhs.nn = 0;
+    rhs.v = 0;
+}
+
 template <class T>
 inline void Vec<T>::SetLength(int n)
 {
     if (n!=nn) {
-        if (v != 0) delete [] (v);
+        AlignedFree(v);
         nn=n;
-        v= new T[nn];
+        v=AlignedAlloc<T>(nn);
     }
 }
 
@@ -68,17 +81,22 @@ Vec<T> & Vec<T>::operator=(const Vec<T> &rhs)
 {
     if (this != &rhs)
     {
-        if (nn != rhs.nn) {
-            if (v != 0) delete [] (v);
-            nn=rhs.nn;
-            v= new T[nn];
-        }
+        SetLength(rhs.nn);
         for (int i=0; i<nn; i++)
             v[i]=rhs[i];
     }
     return *this;
 }
 
+template <class T>
+Vec<T> & Vec<T>::operator=(Vec<T> &&rhs) noexcept
+// postcondition: buffers of vector and rhs are exchanged
+{
+    int n(nn); nn=rhs.nn; rhs.nn=n;
+    T *p(v); v=rhs.v; rhs.v=p;
+    return *this;
+}
+
 template <class T>
 Vec<T> & Vec<T>::operator=(const T &a)    //assign a to every element
 {
@@ -99,6 +117,18 @@ inline const T & Vec<T>::operator[](const int i) const    //subscripting
     return v[i];
 }
 
+template <class T>
+inline T* Vec<T>::data()
+{
+    return v;
+}
+
+template <class T>
+inline const T* Vec<T>::data() const
+{
+    return v;
+}
+
 template <class T>
 inline int Vec<T>::size() const
 {
@@ -108,10 +138,11 @@ inline int Vec<T>::size() const
 template <class T>
 Vec<T>::~Vec()
 {
-    if (v != 0)
-        delete[] (v);
+    AlignedFree(v);
 }
 
+typedef Vec<float> Vec_SP, Vec_O_SP, Vec_IO_SP;
+typedef const Vec<float> Vec_I_SP;
 typedef Vec<double> Vec_DP, Vec_O_DP, Vec_IO_DP;
 typedef Vec<int> Vec_INT, Vec_O_INT, Vec_IO_INT;
 typedef const Vec<double> Vec_I_DP;
@@ -0,0 +1,78 @@
+// online reconstruction: projections are filtered and
+//   backprojected as they arrive, so that an image is
+//   available at any time during acquisition
+// arithmetic is that of filtering and BackProject (CT.cpp), so
+//   that snapshot after adding directions k=0,...,m-1 in order
+//   is identical to reconstruct(B,A) on the whole sinogram A
+
+#include "Accumulator.h"
+#include<cmath>
+
+static double PI(atan(1)*4);
+
+template<class T>
+Accumulator<T>::Accumulator(int n, int m, int M, int N,
+                            int window, double cutoff)
+// n = number of parallel X-rays per direction
+// m = number of directions of X-ray in full sinogram
+//   (direction k is at angle k*pi/m)
+// M,N = height and width of image (both n/2 if M==0)
+// window, cutoff = see Filter in fft.cpp
+: n(n), m(m), M(M ? M : n>>1), N(M ? N : n>>1), count(0),
+  F(GetFFT<T>(FFTLength(n))), H(GetFilter<T>(FFTLength(n),window,cutoff)), g(n)
+{
+    X = (this->M-1)/2.;
+    Y = (this->N-1)/2.;
+    R = sqrt(X*X + Y*Y);
+    dr = 2*R/(n-1);
+    dth = PI/m;
+    B.SetDims(this->M, this->N);
+    y.SetLength(this->N);
+    for(int j=0; j<this->N; j++) y[j] = j;
+    clear();
+}
+
+template<class T>
+void Accumulator<T>::clear()
+// discard all projections added
+{
+    count = 0;
+    B = T(0);
+}
+
+template<class T>
+void Accumulator<T>::add(const T *a, int k, int la)
+// add projection of direction k given by a[i*la] (0<=i<n)
+// cost is O(n log n) for filtering and O(M*N) for backprojection
+{
+    if(k<0 || k>=m) error("Accumulator: bad direction");
+    filtering(&g[0], 1, a, la, n, 1, F, H);
+    T cth(cos(k*dth)/dr), sth(sin(k*dth)/dr);
+    parallel_for(M, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            BackProject(B[i], &g[0], n, T((i-X)*cth - Y*sth + R/dr), sth, &y[0], N);
+    });
+    count++;
+}
+
+template<class T>
+void Accumulator<T>::add(const Mat<T>& A, int k)
+// add column k of sinogram A (shape(n,m))
+{
+    if(A.nrows()!=n || A.ncols()!=m) error("Accumulator: shape differs");
+    add(A[0]+k, k, A.stride());
+}
+
+template<class T>
+void Accumulator<T>::snapshot(Mat<T>& C) const
+// C = image from projections added so far (shape(M,N)),
+//   normalized by their number; cost is O(M*N)
+{
+    C.SetDims(M,N);
+    int c(MAX(count,1));
+    for(int i=0; i<M; i++)
+        for(int j=0; j<N; j++) C[i][j] = B[i][j]/c;
+}
+
+template class Accumulator<float>;
+template class Accumulator<double>;
@@ -0,0 +1,1113 @@
+// benchmarks of transforms
+// usage: a.out name [n] [threads]
+//   name = backscan, interp, parallel, filtering, fft, precision,
+//          butterfly, workspace, reconstructor, stack, stream,
+//          datafile, bmp, stats, accumulator, roi, projector,
+//          fourier, iterative, progressive, sizes
+//   n = image size
+//   threads = number of threads (parallel only)
+//           = number of slices (stack, stream, datafile and bmp)
+
+#include "Radon.h"
+#include "Butterfly.h"
+#include "Stream.h"
+#include "DataFile.h"
+#include "Accumulator.h"
+#include "Progressive.h"
+#include<cmath>
+#include<chrono>
+#include<cstring>
+#include<cstdio>
+#include<fstream>
+#include<iterator>
+#include<algorithm>
+#include<vector>
+#include<thread>
+
+static double PI(atan(1)*4);
+
+static double now()
+// wall clock in seconds
+{
+    using namespace std::chrono;
+    return duration<double>(
+        steady_clock::now().time_since_epoch()).count();
+}
+
+static void RandomMat(Mat_DP& A, int n, int m)
+{
+    A.SetDims(n,m);
+    for(int i=0; i<n; i++)
+        for(int j=0; j<m; j++) A[i][j] = rand()/(RAND_MAX+1.);
+}
+
+static double MaxDiff(const Mat_DP& A, const Mat_DP& B, int M)
+// max |A-B| / max |B| over first M rows
+{
+    double d(0),b(0);
+    for(int i=0; i<M; i++)
+        for(int j=0; j<B.ncols(); j++) {
+            d = MAX(d, fabs(A[i][j] - B[i][j]));
+            b = MAX(b, fabs(B[i][j]));
+        }
+    return d/b;
+}
+
+static void BackScan_ref(Mat_DP& B, const Mat_DP& A, int M1)
+// original BackScan in CT.cpp evaluated on first M1 rows
+//   (cos,sin and interp() for every pixel and direction)
+{
+    int n(A.nrows()), m(A.ncols());
+    int i,j,k;
+    int M(B.nrows()), N(B.ncols());
+    double X((M-1)/2.), Y((N-1)/2.), R(sqrt(X*X + Y*Y));
+    double dr(2*R/(n-1)), dth(PI/m);
+    double x,y,r1,theta;
+    Vec_DP r(n),f[m];
+    for(i=0; i<n; i++) r[i] = i*dr - R;
+    for(k=0; k<m; k++) {
+        f[k].SetLength(n);
+        for(i=0; i<n; i++) f[k][i] = A[i][k];
+    }
+    for(i=0; i<M1; i++) {
+        x = i-X;
+        for(j=0; j<N; j++) {
+            y = j-Y;
+            B[i][j] = 0;
+            for(k=0; k<m; k++) {
+                theta = k*dth;
+                r1 = x*cos(theta) + y*sin(theta);
+                B[i][j] += interp(r1,r,f[k],0);
+            }
+            B[i][j] /= m;
+        }
+    }
+}
+
+static void backscan(int n)
+// BackScan(Mat_DP&, const Mat_DP&) of n*n image
+//   from 2n*4n sinogram
+{
+    int M1(MIN(n,16));
+    double t,t1;
+    Mat_DP A,B,C;
+    RandomMat(A, n<<1, n<<2);
+    B.SetDims(n,n);
+    C.SetDims(n,n);
+    t = now();
+    BackScan(B,A);
+    t = now() - t;
+    t1 = now();
+    BackScan_ref(C,A,M1);
+    t1 = (now() - t1)*n/M1;
+    printf("backscan n=%d: %.3fs (original %.3fs, x%.1f) "
+           "error=%.1e\n", n, t, t1, t1/t, MaxDiff(B,C,M1));
+}
+
+static void interpolation(int n)
+// samples/second of interp2d() on n*n grid
+//   evaluated in batches along X-rays as in scan()
+{
+    int i,k,m(1<<14);
+    double t,r,th,s(0),s1(0),s2(0),t0(0),t1(0),t2(0);
+    Mat_DP z;
+    Vec_DP x(n),y(n),x1(n),y1(n),z1(n);
+    Grid gx(-1,2./(n-1),n), gy(-1,2./(n-1),n);
+    RandomMat(z,n,n);
+    for(i=0; i<n; i++) x[i] = y[i] = gx[i];
+    for(i=0; i<m; i++) {
+        th = PI*rand()/RAND_MAX;
+        r = 2.*rand()/RAND_MAX - 1;
+        for(k=0; k<n; k++) {
+            t = 2.*k/n - 1;
+            x1[k] = r*cos(th) - t*sin(th);
+            y1[k] = r*sin(th) + t*cos(th);
+        }
+        t = now();
+        for(k=0; k<n; k++) s += interp2d(x1[k],y1[k],x,y,z,0);
+        t0 += now() - t;
+        t = now();
+        for(k=0; k<n; k++) s1 += interp2d(x1[k],y1[k],gx,gy,z,0);
+        t1 += now() - t;
+        t = now();
+        interp2d(&z1[0],&x1[0],&y1[0],n,gx,gy,z,0);
+        for(k=0; k<n; k++) s2 += z1[k];
+        t2 += now() - t;
+    }
+    m *= n;
+    printf("interp2d n=%d: bisection %.1f, grid %.1f, batch %.1f "
+           "Msamples/s (error %.1e, %.1e)\n", n,
+           m/t0*1e-6, m/t1*1e-6, m/t2*1e-6,
+           fabs(s1-s)/fabs(s), fabs(s2-s)/fabs(s));
+}
+
+static void filtering_ref(Mat_DP& B, const Mat_DP& A)
+// original filtering in CT.cpp (one column at a time)
+{
+    int i,j,n(A.nrows()),m(A.ncols());
+    double c(PI/n),c2(2./n);
+    Vec_DP v(n);
+    B.SetDims(n,m);
+    for(j=0; j<m; j++) {
+        for(i=0; i<n; i++) v[i] = A[i][j];
+        realft(v,1);
+        v[0] = 0;
+        v[1] *= PI/2;
+        for(i=2; i<n; i++) v[i] *= (i>>1)*c;
+        realft(v,-1);
+        for(i=0; i<n; i++) B[i][j] = v[i]*c2;
+    }
+}
+
+static bool same(const Mat_DP& A, const Mat_DP& B)
+// true if A and B are byte-identical
+{
+    if(A.nrows()!=B.nrows() || A.ncols()!=B.ncols()) return false;
+    for(int i=0; i<A.nrows(); i++)
+        if(memcmp(A[i], B[i], sizeof(double)*A.ncols())) return false;
+    return true;
+}
+
+static bool same(const Radon& a, const Radon& b)
+{
+    for(int k=0; k<4; k++) if(!same(a[k],b[k])) return false;
+    return true;
+}
+
+static void parallel(int n, int p)
+// all transforms with 1 and p threads
+//   n = image size of fast transforms
+{
+    int i,m(MIN(n,64));
+    double t[2];
+    Mat_DP A,B,C[2],D[2],E[2],F[2],G[2],H[2],I[2];
+    Radon d[2],e[2],f[2];
+    RandomMat(A,n,n);
+    RandomMat(B,m,m);
+    for(i=0; i<2; i++) {
+        SetNumThreads(i ? p : 1);
+        t[i] = now();
+        scan(C[i],B);
+        filtering(D[i],C[i]);
+        BackScan(E[i],D[i]);
+        scan(d[i],A);
+        stitch(F[i],d[i]);
+        filtering(e[i],d[i]);
+        BackScan(G[i],e[i]);
+        SinogramFromRadon(H[i],d[i]);
+        RadonFromSinogram(f[i],H[i]);
+        reconstruct(I[i],f[i]);
+        t[i] = now() - t[i];
+    }
+    printf("parallel n=%d: 1 thread %.3fs, %d threads %.3fs "
+           "(identical: %s)\n", n, t[0], p, t[1],
+           same(C[0],C[1]) && same(D[0],D[1]) && same(E[0],E[1])
+           && same(d[0],d[1]) && same(F[0],F[1]) && same(e[0],e[1])
+           && same(G[0],G[1]) && same(H[0],H[1]) && same(f[0],f[1])
+           && same(I[0],I[1]) ? "yes" : "NO");
+}
+
+static void filtering(int n)
+// filtering() of n*2n matrix along axis=0
+{
+    double t,t1,b(16.*n*(n<<1));// bytes read and written
+    Mat_DP A,B,C;
+    RandomMat(A,n,n<<1);
+    t = now();
+    filtering(B,A);
+    t = now() - t;
+    t1 = now();
+    filtering_ref(C,A);
+    t1 = now() - t1;
+    printf("filtering n=%d: %.3fs %.2fGB/s (column by column "
+           "%.3fs %.2fGB/s) error=%.1e\n", n, t, b/t*1e-9,
+           t1, b/t1*1e-9, MaxDiff(B,C,n));
+}
+
+static void fft(int n)
+// forward and inverse real FFT of length n (16 interleaved),
+// compared with realft (n=2^k) or a direct DFT (otherwise)
+{
+    int i,k,m(MAX(1,(1<<22)/n)),nb(16);
+    double t,t1,e(0);
+    const FFT<double>& F(GetFFT<double>(n));
+    Vec_DP u(n*nb),v(n*nb);
+    for(i=0; i<n*nb; i++) u[i] = v[i] = rand()/(RAND_MAX+1.);
+    t = now();
+    for(k=0; k<m; k++) {
+        F.forward(&u[0],nb);
+        F.inverse(&u[0],nb);
+        for(i=0; i<n*nb; i++) u[i] *= 2./n;
+    }
+    t = now() - t;
+    if(n&(n-1)) {// realft needs a power of 2; check one column by DFT
+        int j;
+        double re,im,e1(0);
+        for(i=0; i<n*nb; i++) e = MAX(e, fabs(u[i]-v[i]));
+        F.forward(&v[0],nb);
+        for(k=0; k<=n/2; k++) {
+            for(re=im=j=0; j<n; j++) {
+                re += u[j*nb]*cos(2*PI*j*k/n);
+                im += u[j*nb]*sin(2*PI*j*k/n);
+            }
+            if(k==0) re -= v[0];
+            else if(k==n/2) re -= v[nb];
+            else { re -= v[2*k*nb]; im -= v[(2*k+1)*nb]; }
+            e1 = MAX(e1, fabs(re) + fabs(im));
+        }
+        printf("fft n=%d: plan %.2fus per transform "
+               "(difference %.1e after %d round trips, "
+               "%.1e from DFT)\n", n, t/m/nb*1e6, e, m, e1);
+        return;
+    }
+    t1 = now();
+    for(k=0; k<m; k++) {
+        realft(&v[0],n,nb,1);
+        realft(&v[0],n,nb,-1);
+        for(i=0; i<n*nb; i++) v[i] *= 2./n;
+    }
+    t1 = now() - t1;
+    for(i=0; i<n*nb; i++) e = MAX(e, fabs(u[i]-v[i]));
+    printf("fft n=%d: plan %.2fus, realft %.2fus per transform "
+           "(difference %.1e after %d round trips)\n", n,
+           t/m/nb*1e6, t1/m/nb*1e6, e, m);
+}
+
+template<class T, class U>
+static void convert(Mat<T>& B, const Mat<U>& A)
+{
+    B.SetDims(A.nrows(), A.ncols());
+    for(int i=0; i<A.nrows(); i++)
+        for(int j=0; j<A.ncols(); j++) B[i][j] = A[i][j];
+}
+
+static double RmsDiff(const Mat_DP& A, const Mat_DP& B)
+// rms |A-B| / rms |B|
+{
+    double d(0),b(0);
+    for(int i=0; i<B.nrows(); i++)
+        for(int j=0; j<B.ncols(); j++) {
+            d += SQR(A[i][j] - B[i][j]);
+            b += SQR(B[i][j]);
+        }
+    return sqrt(d/b);
+}
+
+static void precision()
+// float vs double reconstruction of fig1.bmp phantom
+{
+    double t[4];
+    Mat_DP A,B[2],C[2],D;
+    Mat_SP Af,Bf,Cf,Df;
+    Radon d;
+    Radon_SP df;
+    ReadBMP32(A, "fig1.bmp");
+    convert(Af,A);
+    t[0] = now();
+    scan(d,A);
+    reconstruct(B[0],d);
+    t[0] = now() - t[0];
+    t[1] = now();
+    scan(df,Af);
+    reconstruct(Bf,df);
+    t[1] = now() - t[1];
+    t[2] = now();
+    scan(D,A);
+    reconstruct(C[0],D);
+    t[2] = now() - t[2];
+    t[3] = now();
+    scan(Df,Af);
+    reconstruct(Cf,Df);
+    t[3] = now() - t[3];
+    convert(B[1],Bf);
+    convert(C[1],Cf);
+    printf("precision: fast DRT double %.3fs float %.3fs, "
+           "float-double %.1e (error vs phantom %.4f, %.4f)\n",
+           t[0], t[1], RmsDiff(B[1],B[0]), RmsDiff(B[0],A), RmsDiff(B[1],A));
+    printf("precision: CT double %.3fs float %.3fs, "
+           "float-double %.1e (error vs phantom %.4f, %.4f)\n",
+           t[2], t[3], RmsDiff(C[1],C[0]), RmsDiff(C[0],A), RmsDiff(C[1],A));
+}
+
+static void ScanStep_ref(Mat_DP& a, int h, int y)
+// original row by row step of scan in FastCT.cpp
+{
+    int i,j,k,l,m(a.ncols()+h);
+    int h1(h>>1),y1(y+h1);
+    double b[h];
+    for(i=m-1; i>=0; i--) {
+        for(j=0; j<h; j++) {
+            k = j>>1; l = (j+1)>>1;
+            b[j] = a[i][y+k];
+            if(i>=l) b[j] += a[i-l][y1+k];
+        }
+        for(j=0; j<h; j++) a[i][y+j] = b[j];
+    }
+}
+
+static void BackScanStep_ref(Mat_DP& a, int h, int y)
+// original row by row step of BackScan in FastCT.cpp
+{
+    int i,j,k,l,m(a.nrows()-h);
+    int h1(h>>1),y1(y+h1);
+    double b[h];
+    for(i=0; i<m; i++) {
+        for(j=0; j<h; j++) {
+            k = j>>1; l = (j+1)>>1;
+            b[j] = a[i][y+k] + a[i+l][y1+k];
+        }
+        for(j=0; j<h; j++) a[i][y+j] = b[j];
+    }
+}
+
+static void butterfly(int n)
+// samples/second of each level of scan and BackScan
+//   on 2n*n plane: original row by row step vs
+//   column by column step with each instruction set,
+//   and two levels fused in one pass (best instruction set)
+{
+    const char *name[] = {"scalar", "avx2", "avx512"};
+    int h,i,j,l,s,y,c,v,L(SimdLevel());
+    double t,m,m1,t1[3],t2,T[3];
+    bool ok;
+    Mat_DP A,B,W[3][2],V[2];
+    if(n&(n-1)) error("n must be power of 2");
+    RandomMat(A,n<<1,n);
+    for(s=0; s<2; s++) {
+        if(s==0)// scan needs zero padding
+            for(i=n; i<(n<<1); i++) for(j=0; j<n; j++) A[i][j] = 0;
+        B = A;
+        for(l=0; l<=L+1; l++) {
+            Mat_DP& w(l<=L ? W[l][0] : V[0]);
+            w.SetDims(n,n<<1);
+            for(i=0; i<(n<<1); i++)
+                for(j=0; j<n; j++) w[j][i] = A[i][j];
+            (l<=L ? W[l][1] : V[1]) = w;
+        }
+        T[0] = T[1] = T[2] = m1 = 0;
+        for(h=2, c=v=0; h<=n; h<<=1, c=1-c) {
+            m = double(n)*(s ? (n<<1)-h : n+h);// samples per level
+            t = now();
+            for(y=0; y<n; y+=h)
+                if(s) BackScanStep_ref(B,h,y); else ScanStep_ref(B,h,y);
+            t = now() - t;
+            T[0] += t;
+            for(l=0; l<=L; l++) {
+                SetSimdLevel(l);
+                t1[l] = now();
+                for(y=0; y<n; y+=h)
+                    if(s) BackScanStep(W[l][1-c],W[l][c],h,y,0,h>>1);
+                    else ScanStep(W[l][1-c],W[l][c],h,y,0,h>>1);
+                t1[l] = now() - t1[l];
+            }
+            T[1] += t1[L];
+            printf("%s n=%d h=%d: original %.3f", s ? "BackScan" : "scan",
+                   n, h, m/t*1e-9);
+            for(l=0; l<=L; l++) printf(", %s %.3f", name[l], m/t1[l]*1e-9);
+            m1 += m;
+            if(__builtin_ctz(n/h)&1) {// first of fused pair
+                printf(" Gsamples/s\n");
+                continue;
+            }
+            t2 = now();
+            for(y=0; y<n; y+=h)
+                if(m1==m) {// single level
+                    if(s) BackScanStep(V[1-v],V[v],h,y,0,h>>1);
+                    else ScanStep(V[1-v],V[v],h,y,0,h>>1);
+                }
+                else if(s) BackScanStep4(V[1-v],V[v],h,y,0,h>>2);
+                else ScanStep4(V[1-v],V[v],h,y,0,h>>2);
+            t2 = now() - t2;
+            v = 1-v;
+            T[2] += t2;
+            printf(", fused %.3f Gsamples/s\n", m1/t2*1e-9);
+            m1 = 0;
+        }
+        for(ok=true, l=0; l<=L+1; l++) {
+            Mat_DP& w(l<=L ? W[l][c] : V[v]);
+            for(i=0; i<(s ? n : n<<1); i++)// rows i>=n are not used
+                for(j=0; j<n; j++)
+                    ok &= (memcmp(&w[j][i], &B[i][j], sizeof(double))==0);
+        }
+        printf("%s n=%d: total original %.3fs, %s %.3fs, fused %.3fs "
+               "(identical: %s)\n", s ? "BackScan" : "scan", n,
+               T[0], name[L], T[1], T[2], ok ? "yes" : "NO");
+    }
+    SetSimdLevel(L);
+}
+
+static void workspace(int n)
+// arrays allocated by repeated transforms without and with
+//   Workspace (fast transforms of n*n image and sinogram
+//   transforms of min(n,64)^2 image) after first call
+{
+    int i,k,r(5),m(MIN(n,64));
+    long a[2];
+    double t[2];
+    Mat_DP A,B,C,D[2],E[2];
+    Radon d[2];
+    Workspace<double> ws;
+    RandomMat(A,n,n);
+    RandomMat(B,m,m);
+    scan(C,B);
+    for(k=0; k<2; k++)
+        for(i=0; i<=r; i++) {
+            if(i==1) {// after warm-up
+                a[k] = Allocations;
+                t[k] = now();
+            }
+            if(k) {
+                scan(d[k],A,ws);
+                reconstruct(D[k],d[k],ws);
+                reconstruct(E[k],C,ws);
+            }
+            else {
+                scan(d[k],A);
+                reconstruct(D[k],d[k]);
+                reconstruct(E[k],C);
+            }
+            if(i==r) {
+                a[k] = Allocations - a[k];
+                t[k] = (now() - t[k])/r;
+            }
+        }
+    printf("workspace n=%d: %ld arrays %.3fs per call without, "
+           "%ld arrays %.3fs per call with Workspace (identical: %s)\n",
+           n, a[0]/r, t[0], a[1]/r, t[1],
+           same(d[0],d[1]) && same(D[0],D[1]) && same(E[0],E[1])
+           ? "yes" : "NO");
+}
+
+static void reconstructor(int n)
+// slices of n*n image from sinogram of shape(2n,4n)
+//   by free functions and by Reconstructor, which is also
+//   applied to a view of the sinogram with unaligned stride
+{
+    int i,j,r(4);
+    double t[3] = {0,0,0},u[2];
+    Mat_DP A,S,B[3],P[2];
+    Radon d,e;
+    Workspace<double> ws;
+    RandomMat(A,n,n);
+    scan(d,A);
+    SinogramFromRadon(S,d);
+    t[0] = now();
+    Reconstructor<double> R(n, S.ncols(), S.nrows());
+    t[0] = now() - t[0];
+    for(i=0; i<=r; i++) {
+        if(i==1) t[1] = now();
+        RadonFromSinogram(e,S);
+        reconstruct(B[0],e,ws);
+    }
+    t[1] = (now() - t[1])/r;
+    for(i=0; i<=r; i++) {
+        if(i==1) t[2] = now();
+        R.reconstruct(B[1],S);
+    }
+    t[2] = (now() - t[2])/r;
+    u[0] = now();
+    SinogramFromRadon(P[0],d);
+    u[0] = now() - u[0];
+    u[1] = now();
+    R.SinogramFromRadon(P[1],d);
+    u[1] = now() - u[1];
+    int m(S.ncols()+1);// stride of view
+    Vec_DP v(S.nrows()*m);
+    Mat_DP V(&v[0], S.nrows(), S.ncols(), m);
+    for(i=0; i<S.nrows(); i++)
+        for(j=0; j<S.ncols(); j++) V[i][j] = S[i][j];
+    R.reconstruct(B[2],V);
+    printf("reconstructor n=%d: setup %.3fs, reconstruct %.3fs "
+           "(functions %.3fs), SinogramFromRadon %.3fs "
+           "(function %.3fs) (identical: %s)\n", n, t[0], t[2],
+           t[1], u[1], u[0],
+           same(B[0],B[1]) && same(B[0],B[2])
+           && same(P[0],P[1]) ? "yes" : "NO");
+}
+
+static void stack(int n, int S)
+// scan and reconstruct of S slices of n*n images
+//   one by one and as a stack (Mat3D)
+{
+    int i,j,k,r;
+    double t[2][2];
+    bool ok(true);
+    Mat3D_DP A,B;
+    Mat_DP a[2];
+    Radon d[2];
+    RadonStack<double> e;
+    Workspace<double> ws;
+    A.SetDims(S,n,n);
+    for(r=0; r<S; r++)
+        for(i=0; i<n; i++)
+            for(j=0; j<n; j++) A[r][i][j] = rand()/(RAND_MAX+1.);
+    scan(e,A);// warm-up
+    reconstruct(B,e);
+    t[0][0] = t[0][1] = 0;
+    for(r=0; r<S; r++) {
+        a[0].SetDims(n,n);
+        for(i=0; i<n; i++)
+            for(j=0; j<n; j++) a[0][i][j] = A[r][i][j];
+        t[0][0] -= now();
+        scan(d[0],a[0],ws);
+        t[0][0] += now();
+        t[0][1] -= now();
+        reconstruct(a[1],d[0],ws);
+        t[0][1] += now();
+        for(k=0; k<4; k++)
+            for(i=0; i<2*n; i++)
+                ok &= (memcmp(d[0][k][i], e[k][r][i], sizeof(double)*n)==0);
+        for(i=0; i<n; i++)
+            ok &= (memcmp(a[1][i], B[r][i], sizeof(double)*n)==0);
+    }
+    t[1][0] = now();
+    scan(e,A);
+    t[1][0] = now() - t[1][0];
+    t[1][1] = now();
+    reconstruct(B,e);
+    t[1][1] = now() - t[1][1];
+    printf("stack n=%d S=%d: scan %.3fs reconstruct %.3fs "
+           "(slice by slice %.3fs %.3fs) (identical: %s)\n", n, S,
+           t[1][0], t[1][1], t[0][0], t[0][1], ok ? "yes" : "NO");
+}
+
+static void stream(int n, int S)
+// S slices reconstructed from sinograms one by one and by
+//   pipeline; reading and writing each slice take as long as
+//   resampling (sleep for disk or detector); then bytes
+//   allocated by pipeline are checked against its budget
+{
+    int i,r;
+    double t[2],u;
+    bool ok(true);
+    Mat_DP A,B[2],C;
+    Radon d;
+    Reconstructor<double> R(n, 4*n, 2*n);
+    RandomMat(A,n,n);
+    R.project(C,A);
+    u = now();
+    R.RadonFromSinogram(d,C);
+    u = now() - u;
+    auto wait = [u]{ std::this_thread::sleep_for(std::chrono::duration<double>(u)); };
+    t[0] = now();
+    for(r=0; r<S; r++) {
+        wait();
+        A = C;
+        R.reconstruct(B[0],A);
+        wait();
+    }
+    t[0] = now() - t[0];
+    r = 0;
+    t[1] = now();
+    stream(R, [&](Mat_DP& a) {
+        if(r==S) return false;
+        wait();
+        a = C;
+        r++;
+        return true;
+    }, [&](const Mat_DP& b) {
+        wait();
+        for(i=0; i<n; i++)
+            ok &= (memcmp(b[i], B[0][i], sizeof(double)*n)==0);
+    });
+    t[1] = now() - t[1];
+    printf("stream n=%d S=%d: one by one %.3fs, pipeline %.3fs "
+           "(read and write %.3fs each) (identical: %s)\n",
+           n, S, t[0], t[1], u, ok && r==S ? "yes" : "NO");
+    long x(64L*n*n*sizeof(double)),y(AllocatedBytes);// budget
+    r = 0;
+    stream(R, [&](Mat_DP& a) {
+        if(r==S) return false;
+        a = C;
+        r++;
+        return true;
+    }, [&](const Mat_DP&) {}, x);
+    y = AllocatedBytes - y;
+    printf("  budget %ld bytes: allocated %ld\n", x, y);
+    if(y > x) error("stream: allocation exceeds budget");
+}
+
+static void save_ref(const char *file_name, const Mat_DP& A)
+// former save(): one double at a time
+{
+    int i,j,m(A.nrows()),n(A.ncols());
+    std::ofstream s(file_name, std::ofstream::binary);
+    s.write((const char *)&m, sizeof(int));
+    s.write((const char *)&n, sizeof(int));
+    for(i=0; i<m; i++) for(j=0; j<n; j++)
+        s.write((const char*)&A[i][j], sizeof(double));
+}
+
+static void load_ref(Mat_DP& A, const char *file_name)
+// former load(): one double at a time
+{
+    int i,j,m,n;
+    std::ifstream s(file_name, std::ifstream::binary);
+    s.read((char *)&m, sizeof(int));
+    s.read((char *)&n, sizeof(int));
+    A.SetDims(m,n);
+    for(i=0; i<m; i++) for(j=0; j<n; j++)
+        s.read((char *)&A[i][j], sizeof(double));
+}
+
+static void datafile(int n, int S)
+// S slices of n by n saved and loaded by former save/load
+//   (one file per slice) and by DataFile (appended to one
+//   file and viewed through mapping without copy)
+{
+    int i,j,r;
+    double t[4],a(0),b(0);
+    bool ok(true);
+    char name[32];
+    Mat_DP A,B;
+    RandomMat(A,n,n);
+    t[0] = now();
+    for(r=0; r<S; r++) {
+        sprintf(name, "bench%d.dat", r);
+        save_ref(name, A);
+    }
+    t[0] = now() - t[0];
+    t[1] = now();
+    for(r=0; r<S; r++) {
+        sprintf(name, "bench%d.dat", r);
+        load_ref(B, name);
+        for(i=0; i<n; i++) for(j=0; j<n; j++) a += B[i][j];
+        remove(name);
+    }
+    t[1] = now() - t[1];
+    t[2] = now();
+    {
+        DataFile f;
+        f.create("bench.dat", DATA_DOUBLE, n, n);
+        for(r=0; r<S; r++) f.append(A);
+    }
+    t[2] = now() - t[2];
+    t[3] = now();
+    {
+        DataFile f;
+        f.open("bench.dat");
+        for(r=0; r<f.slices(); r++) {
+            const Mat_DP C(f.slice<double>(r));
+            for(i=0; i<n; i++) for(j=0; j<n; j++) b += C[i][j];
+            ok &= same(B,C);
+        }
+    }
+    t[3] = now() - t[3];
+    remove("bench.dat");
+    printf("datafile n=%d S=%d: save %.3fs, load %.3fs, "
+           "append %.3fs, mapped view %.3fs (identical: %s)\n",
+           n, S, t[0], t[1], t[2], t[3], ok && a==b ? "yes" : "NO");
+}
+
+static void WriteBMP32_ref(const char *file_name, const Mat_DP& A)
+// former WriteBMP32: three channel copy, one byte at a time
+{
+    int i,j,k,m(A.nrows()),n(A.ncols());
+    double a(min(A)),b(max(A)-a);
+    unsigned long h[3] = {54 + 4UL*m*n, 0, 54};
+    unsigned long g[10] = {40, (unsigned long)n, (unsigned long)m, 1|32UL<<16, 0, 4UL*m*n};
+    Mat3D_DP B;
+    B.SetDims(m,n,3);
+    for(i=0; i<m; i++) for(j=0; j<n; j++)
+        for(k=0; k<3; k++) B[i][j][k] = (A[i][j]-a)/b;
+    std::ofstream s(file_name, std::ofstream::binary);
+    s.write("BM", 2);
+    for(i=0; i<3; i++) s.write((const char*)&h[i], 4);
+    for(i=0; i<10; i++) s.write((const char*)&g[i], 4);
+    for(i=m-1; i>=0; i--)
+        for(j=0; j<n; j++) {
+            for(k=2; k>=0; k--) s.put((unsigned char)(round(B[i][j][k]*255)));
+            s.put(0);
+        }
+}
+
+static void bmp(int n, int S)
+// S slices of n by n written to bitmap files by former
+//   WriteBMP32, by present WriteBMP32 and by WriteBMP8,
+//   and read back by ReadBMP32 and ReadBMP8
+{
+    int i,j,r;
+    double t[4];
+    bool ok(true);
+    Mat_DP A,B;
+    Mat3D_DP M;
+    RandomMat(A,n,n);
+    t[0] = now();
+    for(r=0; r<S; r++) WriteBMP32_ref("bench_ref.bmp", A);
+    t[0] = now() - t[0];
+    t[1] = now();
+    for(r=0; r<S; r++) WriteBMP32("bench.bmp", A);
+    t[1] = now() - t[1];
+    t[2] = now();
+    for(r=0; r<S; r++) WriteBMP8("bench8.bmp", A);
+    t[2] = now() - t[2];
+    t[3] = now();
+    for(r=0; r<S; r++) ReadBMP32(B, "bench.bmp");
+    t[3] = now() - t[3];
+    ReadBMP8(M, "bench8.bmp");
+    for(i=0; i<n; i++) for(j=0; j<n; j++) ok &= (M[i][j][1]==B[i][j]);
+    std::ifstream f0("bench_ref.bmp", std::ifstream::binary);
+    std::ifstream f1("bench.bmp", std::ifstream::binary);
+    ok &= std::equal(std::istreambuf_iterator<char>(f0), std::istreambuf_iterator<char>(),
+                     std::istreambuf_iterator<char>(f1), std::istreambuf_iterator<char>());
+    remove("bench_ref.bmp");
+    remove("bench.bmp");
+    remove("bench8.bmp");
+    printf("bmp n=%d S=%d: former write %.3fs, write %.3fs, "
+           "8bit write %.3fs, read %.3fs (identical: %s)\n",
+           n, S, t[0], t[1], t[2], t[3], ok ? "yes" : "NO");
+}
+
+static void stats(int n)
+// statistics of n by n matrix by former serial passes
+//   (min, max, then sums) and by one sweep of stats();
+//   percentile from histogram is compared with sorted values
+{
+    int i,j,k,r,p(NumThreads()),R(20);
+    double t[2],a,b,s,q;
+    bool ok(true);
+    Mat_DP A;
+    MatStats S,S1;
+    RandomMat(A,n,n);
+    t[0] = now();
+    for(r=0; r<R; r++) {
+        a = A[0][0]; b = A[0][0]; s = q = 0;
+        for(i=0; i<n; i++) for(j=0; j<n; j++) if(A[i][j] < a) a = A[i][j];
+        for(i=0; i<n; i++) for(j=0; j<n; j++) if(A[i][j] > b) b = A[i][j];
+        for(i=0; i<n; i++) for(j=0; j<n; j++) { s += A[i][j]; q += A[i][j]*A[i][j]; }
+    }
+    t[0] = now() - t[0];
+    t[1] = now();
+    for(r=0; r<R; r++) stats(S, A, 4096, a, b);
+    t[1] = now() - t[1];
+    ok &= (S.min==a && S.max==b && fabs(S.sum-s) <= 1e-9*q);
+    SetNumThreads(1);
+    stats(S1, A, 4096, a, b);
+    SetNumThreads(p);
+    ok &= (S1.sum==S.sum && S1.sumsq==S.sumsq);
+    for(k=0; k<4096; k++) ok &= (S1.hist[k]==S.hist[k]);
+    std::vector<double> v(A[0], A[0]);
+    for(i=0; i<n; i++) v.insert(v.end(), A[i], A[i]+n);
+    std::sort(v.begin(), v.end());
+    for(k=1; k<100; k+=49)
+        ok &= fabs(S.percentile(k) - v[long(k)*n*n/100]) <= 2*(b-a)/4096;
+    printf("stats n=%d: serial passes %.3fs, one sweep %.3fs "
+           "(mean %.4f std %.4f; consistent: %s)\n",
+           n, t[0], t[1], S.mean(), S.stdev(), ok ? "yes" : "NO");
+}
+
+static void accumulator(int n)
+// sinogram of 2n X-rays and 2n directions added to Accumulator
+//   one direction at a time, compared with reconstruct;
+//   snapshot is taken after every 16 directions
+{
+    int k,m(2*n);
+    double t[3];
+    Mat_DP A,B,C;
+    RandomMat(A,2*n,m);
+    t[0] = now();
+    reconstruct(B,A);
+    t[0] = now() - t[0];
+    Accumulator<double> acc(2*n, m);
+    t[1] = t[2] = 0;
+    for(k=0; k<m; k++) {
+        double u(now());
+        acc.add(A,k);
+        t[1] += now() - u;
+        if(k%16) continue;
+        u = now();
+        acc.snapshot(C);
+        t[2] += now() - u;
+    }
+    acc.snapshot(C);
+    printf("accumulator n=%d: reconstruct %.3fs, add %.2fms per direction, "
+           "snapshot %.2fms (identical: %s)\n", n, t[0], t[1]/m*1e3,
+           t[2]/((m+15)/16)*1e3, same(B,C) ? "yes" : "NO");
+    if(!same(B,C)) error("accumulator: snapshot differs from reconstruct");
+}
+
+static bool same(const Mat_DP& A, const Mat_DP& B, int i0, int j0, int p)
+// true if A is byte-identical to B[i0+i*p][j0+j*p]
+{
+    for(int i=0; i<A.nrows(); i++)
+        for(int j=0; j<A.ncols(); j++)
+            if(memcmp(&A[i][j], &B[i0+i*p][j0+j*p], sizeof(double))) return false;
+    return true;
+}
+
+static void roi(int n)
+// region of n/4 by n/4 pixels and image decimated by 4
+//   compared with full image by BackScan in CT.cpp
+//   (sinogram of n X-rays, 2n directions) and in FastCT.cpp;
+//   decimated FastCT image of gaussian is compared with
+//   4 by 4 block averages of full image
+{
+    int i,j,i0(n/8),j0(n/4),m(n/4);
+    double t[6],X((n-1)/2.),sg(n/8.);
+    bool ok(true);
+    Mat_DP A,B,C,D;
+    Radon d;
+    Workspace<double> ws;
+    RandomMat(A,2*n,2*n);
+    B.SetDims(n,n);
+    t[0] = now();
+    BackScan(B,A,ws);
+    t[0] = now() - t[0];
+    C.SetDims(m,m);
+    t[1] = now();
+    BackScan(C,A,Region(i0,j0,1,n,n),ws);
+    t[1] = now() - t[1];
+    ok &= same(C,B,i0,j0,1);
+    t[2] = now();
+    BackScan(C,A,Region(0,0,4,n,n),ws);
+    t[2] = now() - t[2];
+    ok &= same(C,B,0,0,4);
+    d.SetSize(n);
+    for(int k=0; k<4; k++) RandomMat(d[k],2*n,n);
+    t[3] = now();
+    BackScan(B,d,ws);
+    t[3] = now() - t[3];
+    t[4] = now();
+    BackScan(C,d,Region(i0,j0),ws);
+    t[4] = now() - t[4];
+    ok &= same(C,B,i0,j0,1);
+    t[5] = now();
+    BackScan(C,d,Region(1.5,1.5,4),ws);
+    t[5] = now() - t[5];
+    A.SetDims(n,n);
+    for(i=0; i<n; i++) for(j=0; j<n; j++)
+        A[i][j] = exp(-(SQR(i-X) + SQR(j-X))/2/SQR(sg));
+    scan(d,A,ws);
+    reconstruct(B,d,ws);
+    reconstruct(C,d,Region(1.5,1.5,4),ws);
+    D.SetDims(m,m,0.);
+    for(i=0; i<n; i++) for(j=0; j<n; j++) D[i>>2][j>>2] += B[i][j]/16;
+    printf("roi n=%d: CT full %.3fs, region %.3fs, decimated %.3fs; "
+           "FastCT full %.3fs, region %.3fs, decimated %.3fs "
+           "(identical: %s, decimated error %.1e)\n", n, t[0], t[1],
+           t[2], t[3], t[4], t[5], ok ? "yes" : "NO", RmsDiff(C,D));
+}
+
+static void projector(int n)
+// sinograms of gaussian image of size n by scan() with
+//   SCAN_SAMPLED and SCAN_JOSEPH compared with exact
+//   projection sqrt(2pi)*sigma*exp(-r^2/2/sigma^2)/dr
+{
+    int i,j,k;
+    double t[2],X((n-1)/2.),R(X*sqrt(2.)),sg(n/8.),dr,r;
+    Mat_DP A,B[2],C;
+    A.SetDims(n,n);
+    for(i=0; i<n; i++) for(j=0; j<n; j++)
+        A[i][j] = exp(-(SQR(i-X) + SQR(j-X))/2/SQR(sg));
+    for(k=0; k<2; k++) {
+        B[k].SetDims(n,n);
+        t[k] = now();
+        scan(B[k], A, k ? SCAN_JOSEPH : SCAN_SAMPLED);
+        t[k] = now() - t[k];
+    }
+    C.SetDims(n,n);
+    dr = 2*R/(n-1);
+    for(i=0; i<n; i++) {
+        r = i*dr - R;
+        for(j=0; j<n; j++) C[i][j] = sqrt(2*PI)*sg*exp(-r*r/2/SQR(sg))/dr;
+    }
+    printf("projector n=%d: sampled %.3fs (error %.2e), "
+           "joseph %.3fs (error %.2e)\n",
+           n, t[0], RmsDiff(B[0],C), t[1], RmsDiff(B[1],C));
+}
+
+static void fourier(int n)
+// gaussian image of size n reconstructed from its sinogram
+//   by CT, FastCT and FourierReconstruct (gridding)
+{
+    int i,j;
+    double t[3],X((n-1)/2.),sg(n/8.);
+    Mat_DP A,B,C,D,E;
+    Radon d;
+    A.SetDims(n,n);
+    for(i=0; i<n; i++) for(j=0; j<n; j++)
+        A[i][j] = exp(-(SQR(i-X) + SQR(j-X))/2/SQR(sg));
+    scan(D, A, SCAN_JOSEPH);
+    t[0] = now();
+    reconstruct(B,D);
+    t[0] = now() - t[0];
+    t[1] = now();
+    RadonFromSinogram(d,D);
+    reconstruct(C,d);
+    t[1] = now() - t[1];
+    t[2] = now();
+    FourierReconstruct(E,D);
+    t[2] = now() - t[2];
+    printf("fourier n=%d: CT %.3fs (error %.2e), FastCT %.3fs (error %.2e), "
+           "gridding %.3fs (error %.2e)\n",
+           n, t[0], RmsDiff(B,A), t[1], RmsDiff(C,A), t[2], RmsDiff(E,A));
+}
+
+static void iterative(int n)
+// gaussian image of size n from sinogram of n/4 directions:
+//   reconstruct vs solve by SIRT and CGLS (20 iterations)
+//   warm started from reconstruct; error is vs phantom;
+//   data are scaled by dr for solve (see iterative.cpp);
+//   allocations are counted in repeated solve
+{
+    int i,j,k,it[2];
+    long a;
+    double t[3],X((n-1)/2.),sg(n/8.),e;
+    Mat_DP A,B[3],C,D;
+    Radon d,f;
+    Workspace<double> ws;
+    A.SetDims(n,n);
+    for(i=0; i<n; i++) for(j=0; j<n; j++)
+        A[i][j] = exp(-(SQR(i-X) + SQR(j-X))/2/SQR(sg))
+                + (SQR(i-X/2) + SQR(j-X) < SQR(n/10.) ? 1 : 0);
+    D.SetDims(2*n, n/4);
+    scan(D, A, SCAN_JOSEPH);
+    RadonFromSinogram(d,D);
+    t[0] = now();
+    reconstruct(B[0],d,ws);
+    t[0] = now() - t[0];
+    e = sqrt(2.)*(n-1)/(2*n-1);// spacing of X-rays in D
+    for(k=0; k<4; k++) for(i=0; i<2*n; i++) for(j=0; j<n; j++) d[k][i][j] *= e;
+    for(k=0; k<2; k++) {
+        t[k+1] = now();
+        it[k] = solve(B[k+1], d, ws, k ? CGLS : SIRT, 20, 1e-6);
+        t[k+1] = now() - t[k+1];
+    }
+    C = B[1];
+    a = Allocations;
+    for(k=0; k<2; k++) solve(C, d, ws, k ? CGLS : SIRT, 5, 1e-6);
+    a = Allocations - a;
+    // <scan(A),f> vs <A,ScanAdjoint(f)>
+    f.SetSize(n);
+    for(k=0; k<4; k++) RandomMat(f[k], 2*n, n);
+    scan(d,A,ws);
+    ScanAdjoint(C,f,ws);
+    double s1(0),s2(0);
+    for(k=0; k<4; k++) for(i=0; i<2*n; i++) for(j=0; j<n; j++) s1 += d[k][i][j]*f[k][i][j];
+    for(i=0; i<n; i++) for(j=0; j<n; j++) s2 += A[i][j]*C[i][j];
+    e = fabs(s1-s2)/fabs(s1);
+    printf("iterative n=%d: FBP %.3fs (error %.3f), SIRT %d in %.3fs (error %.3f), "
+           "CGLS %d in %.3fs (error %.3f), adjoint mismatch %.1e, "
+           "allocations in repeated solve %ld\n",
+           n, t[0], RmsDiff(B[0],A), it[0], t[1], RmsDiff(B[1],A),
+           it[1], t[2], RmsDiff(B[2],A), e, a);
+}
+
+static void progressive(int n)
+// time at which each level of Progressive (3 levels) is
+//   ready vs reconstruct of full image
+{
+    int i,l;
+    double t[5],t0;
+    Mat_DP A,B,C;
+    Radon d;
+    Workspace<double> ws;
+    Progressive<double> P(3);
+    RandomMat(A,n,n);
+    scan(d,A);
+    for(i=0; i<2; i++) {// second run reuses arrays
+        t0 = now();
+        reconstruct(C,d,ws);
+        t[4] = now() - t0;
+        t0 = now();
+        P.run(B, d, [&](int l, const Mat_DP&) { t[l] = now() - t0; });
+    }
+    printf("progressive n=%d: level", n);
+    for(l=3; l>=0; l--) printf(" %d %.4fs,", n>>l, t[l]);
+    printf(" reconstruct %.4fs (total +%.0f%%, identical: %s)\n", t[4],
+           (t[0]/t[4]-1)*100, same(B,C) ? "yes" : "NO");
+}
+
+static void sizes(int n)
+// image of size n not power of 2 (e.g. 600) compared with
+//   size P = next power of 2: FFT of length FFTLength(2n),
+//   sinogram filtering and reconstruct with n = FFTLength(n+1)
+//   rows; fast reconstruct of n*n image is only checked to
+//   be identical to padding to P*P by hand (it costs as much)
+{
+    int i,k,P(1),m(64),nb(16);
+    while(P<n) P<<=1;
+    int l[2] = {FFTLength(n<<1), P<<1};
+    int r[2] = {FFTLength(n+1), (n+1>P ? P<<1 : P)};
+    double t[2],t0;
+    for(k=0; k<2; k++) {// FFT
+        const FFT<double>& F(GetFFT<double>(l[k]));
+        Vec_DP u(l[k]*nb);
+        for(i=0; i<l[k]*nb; i++) u[i] = rand()/(RAND_MAX+1.);
+        t0 = now();
+        for(i=0; i<m; i++) {
+            F.forward(&u[0],nb);
+            F.inverse(&u[0],nb);
+        }
+        t[k] = (now() - t0)/m/nb;
+    }
+    printf("sizes n=%d: fft length %d %.2fus, %d %.2fus\n",
+           n, l[0], t[0]*1e6, l[1], t[1]*1e6);
+    Mat_DP A,B,C,D;
+    Workspace<double> ws;
+    RandomMat(A,n,n);
+    for(k=0; k<2; k++) {// sinogram
+        B.SetDims(r[k], r[k]<<1);
+        scan(B,A);
+        reconstruct(C,B,ws);// plan and work space
+        t0 = now();
+        reconstruct(C,B,ws);
+        t[k] = now() - t0;
+    }
+    printf("  sinogram %d rows %.3fs, %d rows %.3fs\n",
+           r[0], t[0], r[1], t[1]);
+    Radon d,e;
+    for(k=0; k<4; k++) {// fast transforms (twice for work space)
+        t0 = now();
+        if(k%2==0) {
+            scan(d,A,ws);
+            C.SetDims(n,n);
+            reconstruct(C,d,Region(0,0),ws);
+        }
+        else {
+            D.SetDims(P,P,0.);
+            for(i=0; i<n; i++)
+                for(int j=0; j<n; j++) D[i][j] = A[i][j];
+            scan(e,D,ws);
+            reconstruct(D,e,ws);
+        }
+        t[k%2] = now() - t0;
+    }
+    printf("  fast %d (computed as %d) %.3fs, by hand %.3fs "
+           "(identical: %s)\n", n, P, t[0], t[1],
+           same(C, Mat_DP(&D[0][0], n, n, D.stride())) ? "yes" : "NO");
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc<2) error("usage: a.out name [n] [threads]");
+    int n(argc>2 ? atoi(argv[2]) : 512);
+    if(strcmp(argv[1], "backscan")==0) backscan(n);
+    else if(strcmp(argv[1], "interp")==0) interpolation(n);
+    else if(strcmp(argv[1], "parallel")==0)
+        parallel(n, argc>3 ? atoi(argv[3]) : NumThreads());
+    else if(strcmp(argv[1], "filtering")==0) filtering(n);
+    else if(strcmp(argv[1], "fft")==0) fft(n);
+    else if(strcmp(argv[1], "precision")==0) precision();
+    else if(strcmp(argv[1], "butterfly")==0) butterfly(n);
+    else if(strcmp(argv[1], "workspace")==0) workspace(n);
+    else if(strcmp(argv[1], "reconstructor")==0) reconstructor(n);
+    else if(strcmp(argv[1], "stack")==0)
+        stack(n, argc>3 ? atoi(argv[3]) : 8);
+    else if(strcmp(argv[1], "stream")==0)
+        stream(n, argc>3 ? atoi(argv[3]) : 16);
+    else if(strcmp(argv[1], "datafile")==0)
+        datafile(n, argc>3 ? atoi(argv[3]) : 16);
+    else if(strcmp(argv[1], "stats")==0) stats(n);
+    else if(strcmp(argv[1], "accumulator")==0) accumulator(n);
+    else if(strcmp(argv[1], "roi")==0) roi(n);
+    else if(strcmp(argv[1], "projector")==0) projector(n);
+    else if(strcmp(argv[1], "fourier")==0) fourier(n);
+    else if(strcmp(argv[1], "iterative")==0) iterative(n);
+    else if(strcmp(argv[1], "progressive")==0) progressive(n);
+    else if(strcmp(argv[1], "sizes")==0) sizes(n);
+    else if(strcmp(argv[1], "bmp")==0)
+        bmp(n, argc>3 ? atoi(argv[3]) : 16);
+    else error("unknown benchmark");
+    return 0;
+}
@@ -1,6 +1,76 @@
 #include<fstream>
 #include<cmath>
-#include "Mat3D.h"
+#include "Mat_DP.h"
+#include "Vec.h"
+#include "nr.h"
+
+// pixels are moved a row at a time through a buffer
+//   of bytes as they are laid out in the file
+
+static void put(unsigned char *p, unsigned long x, int n)
+// n bytes of x in little endian
+{
+    for(int i=0; i<n; i++, x>>=8) p[i] = x&255;
+}
+
+static unsigned long get(const unsigned char *p, int n)
+{
+    unsigned long x(0);
+    for(int i=n-1; i>=0; i--) x = (x<<8) | p[i];
+    return x;
+}
+
+static long RowBytes(long biWidth, int biBitCount)
+// length of a row padded to multiple of 4 bytes
+{
+    return (biWidth*biBitCount/8 + 3)/4*4;
+}
+
+static void WriteHeader(std::ofstream& s, long biHeight, long biWidth, int biBitCount)
+// file and info header followed by gray palette if 8bit
+{
+    unsigned char h[54] = {'B','M'};
+    unsigned long nc(biBitCount==8 ? 256 : 0);// colors in palette
+    unsigned long bfOffset(54 + nc*4);
+    unsigned long biSizeImage(biHeight * RowBytes(biWidth, biBitCount));
+    put(h+2, biSizeImage + bfOffset, 4);// bfSize
+    put(h+10, bfOffset, 4);
+    put(h+14, 40, 4);// biSize
+    put(h+18, biWidth, 4);
+    put(h+22, biHeight, 4);
+    put(h+26, 1, 2);// biPlanes
+    put(h+28, biBitCount, 2);
+    put(h+34, biSizeImage, 4);
+    put(h+46, nc, 4);// biClrUsed
+    s.write((const char*)h, 54);
+    for(unsigned long i=0; i<nc; i++) {
+        unsigned char c[4] = {(unsigned char)i, (unsigned char)i, (unsigned char)i, 0};
+        s.write((const char*)c, 4);
+    }
+}
+
+static void ReadHeader(std::ifstream& s, long& biHeight, long& biWidth, int biBitCount,
+                       unsigned char (*color)[4] = 0)
+// s is positioned at the pixels (bfOffBits)
+// if 8bit, palette of biClrUsed colors (256 if 0) is read
+//   into color[256] and the rest of color is set to zero
+{
+    unsigned char h[54];
+    if(!s.read((char*)h, 54) || h[0]!='B' || h[1]!='M')
+        error("ReadBMP: not a bitmap file");
+    if(get(h+28,2) != (unsigned long)biBitCount)
+        error("ReadBMP: unexpected bits per pixel");
+    biWidth = get(h+18,4);
+    biHeight = get(h+22,4);
+    if(color) {
+        unsigned long nc(get(h+46,4));// biClrUsed
+        if(nc==0 || nc>256) nc = 256;
+        for(int i=0; i<256; i++) color[i][0] = color[i][1] = color[i][2] = color[i][3] = 0;
+        s.seekg(14 + get(h+14,4));// palette follows info header
+        s.read((char*)color, nc*4);
+    }
+    s.seekg(get(h+10,4));
+}
 
 void WriteBMP32(const char *file_name, const Mat3D_DP& M)
 // write 32bit bitmap image to file
@@ -12,83 +82,100 @@ void WriteBMP32(const char *file_name, const Mat3D_DP& M)
 {
     long i,j,k;
     long biHeight(M.dim1()), biWidth(M.dim2());
+    Vec<unsigned char> c(biWidth*4);
+    std::ofstream s(file_name, std::ofstream::binary);
+    WriteHeader(s, biHeight, biWidth, 32);
+    for(i=biHeight-1; i>=0; i--) {
+        for(j=0; j<biWidth; j++) {
+            for(k=0; k<3; k++)
+                c[4*j+2-k] = (unsigned char)(round(M[i][j][k]*255));
+            c[4*j+3] = 0;
+        }
+        s.write((const char*)&c[0], biWidth*4);
+    }
+}
+
+void WriteBMP(const char *file_name, const Mat_DP& A, double a, double b, int biBitCount)
+// write A to gray bitmap file without intermediate copy
+// intensity (A[i][j]-a)/b is clipped to [0,1] and quantized
+// biBitCount = 32 (R=G=B) or 8 (gray palette, 1/4 in size)
+// i increases from top to bottom
+// j increases from left to right
+{
+    long i,j,k;
+    long biHeight(A.nrows()), biWidth(A.ncols());
+    int p(biBitCount/8);// bytes per pixel
+    long l(RowBytes(biWidth, biBitCount));
+    double x;
     unsigned char c;
-    unsigned long bfOffset(54);
-    unsigned long biSizeImage(biHeight * biWidth * 4);
-    unsigned long bfSize(biSizeImage + bfOffset);
-    unsigned long biSize(40);
-    unsigned long zero(0);
-    unsigned int one(1);
-    unsigned int biBitCount(32);
+    if(biBitCount!=8 && biBitCount!=32) error("WriteBMP: bad bits per pixel");
+    Vec<unsigned char> r(l);
+    for(j=0; j<l; j++) r[j] = 0;
     std::ofstream s(file_name, std::ofstream::binary);
-    s.write("BM", 2);
-    s.write((const char*)&bfSize, 4);
-    s.write((const char*)&zero, 2);// bfReserved1
-    s.write((const char*)&zero, 2);// bfReserved2
-    s.write((const char*)&bfOffset, 4);
-    s.write((const char*)&biSize, 4);
-    s.write((const char*)&biWidth, 4);
-    s.write((const char*)&biHeight, 4);
-    s.write((const char*)&one, 2);// biPlanes
-    s.write((const char*)&biBitCount, 2);
-    s.write((const char*)&zero, 4);// biCompression
-    s.write((const char*)&biSizeImage, 4);
-    s.write((const char*)&zero, 4);// biXPixPerMeter
-    s.write((const char*)&zero, 4);// biYPixPerMeter
-    s.write((const char*)&zero, 4);// biClrUsed
-    s.write((const char*)&zero, 4);// biClrImportant
-    for(i=biHeight-1; i>=0; i--)
+    WriteHeader(s, biHeight, biWidth, biBitCount);
+    for(i=biHeight-1; i>=0; i--) {
+        const double *a_i(A[i]);
         for(j=0; j<biWidth; j++) {
-            for(k=2; k>=0; k--) {
-                c = (unsigned char)(round(M[i][j][k]*255));
-                s.put(c);
-            }
-            s.put(0);
+            x = (a_i[j]-a)/b;
+            if(!(x>0)) x=0;
+            else if(x>1) x=1;
+            c = (unsigned char)(round(x*255));
+            for(k=0; k<3 && k<p; k++) r[p*j+k] = c;
         }
+        s.write((const char*)&r[0], l);
+    }
 }
 
 void ReadBMP32(Mat3D_DP& M, const char *file_name)
 // read 32bit bitmap image from file
 {
     long i,j,k;
-    long biHeight, biWidth;
-    unsigned char c;
+    long biHeight(0), biWidth(0);
     std::ifstream s(file_name, std::ifstream::binary);
-    s.seekg(18);
-    s.read((char*)&biWidth, 4);
-    s.read((char*)&biHeight, 4);
+    ReadHeader(s, biHeight, biWidth, 32);
     M.SetDims(biHeight, biWidth, 3);
-    s.seekg(28);
-    s.seekg(54);
-    for(i=biHeight-1; i>=0; i--)
-        for(j=0; j<biWidth; j++) {
-            for(k=2; k>=0; k--) {
-                c = s.get();
-                M[i][j][k] = c/255.;
-            }
-            s.get();
-        }
+    Vec<unsigned char> c(biWidth*4);
+    for(i=biHeight-1; i>=0; i--) {
+        s.read((char*)&c[0], biWidth*4);
+        for(j=0; j<biWidth; j++)
+            for(k=0; k<3; k++)
+                M[i][j][k] = c[4*j+2-k]/255.;
+    }
+}
+
+void ReadBMP32(Mat_DP& A, const char *file_name, int color)
+// read matrix data A from bitmap file
+// color = 0,1,2 for R,G,B
+// A[i,j] are real value between 0 and 1
+{
+    long i,j;
+    long biHeight(0), biWidth(0);
+    std::ifstream s(file_name, std::ifstream::binary);
+    ReadHeader(s, biHeight, biWidth, 32);
+    A.SetDims(biHeight, biWidth);
+    Vec<unsigned char> c(biWidth*4);
+    for(i=biHeight-1; i>=0; i--) {
+        s.read((char*)&c[0], biWidth*4);
+        for(j=0; j<biWidth; j++)
+            A[i][j] = c[4*j+2-color]/255.;
+    }
 }
 
 void ReadBMP8(Mat3D_DP& M, const char *file_name)
 // read 8bit bitmap image from file
 {
     long i,j,k;
-    long biHeight, biWidth;
-    unsigned char c;
+    long biHeight(0), biWidth(0);
     unsigned char color[256][4];
     std::ifstream s(file_name, std::ifstream::binary);
-    s.seekg(18);
-    s.read((char*)&biWidth, 4);
-    s.read((char*)&biHeight, 4);
+    ReadHeader(s, biHeight, biWidth, 8, color);
     M.SetDims(biHeight, biWidth, 3);
-    s.seekg(54);
-    for(i=0; i<256; i++)
-        for(j=0; j<4; j++) s.read((char*)&color[i][j], 1);
-    for(i=biHeight-1; i>=0; i--)
-        for(j=0; j<biWidth; j++) {
-            c = s.get();
+    long l(RowBytes(biWidth, 8));
+    Vec<unsigned char> c(l);
+    for(i=biHeight-1; i>=0; i--) {
+        s.read((char*)&c[0], l);
+        for(j=0; j<biWidth; j++)
             for(k=0; k<3; k++)
-                M[i][j][k] = color[c][2-k]/255.;
-        }
+                M[i][j][k] = color[c[j]][2-k]/255.;
+    }
 }
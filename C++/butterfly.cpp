@@ -0,0 +1,414 @@
+// butterfly kernels of fast Radon transform
+//   vectorized by AVX2 or AVX-512 chosen at run time;
+//   only additions are done, so results are identical
+//   for every instruction set
+
+#include<cstring>
+#include "Butterfly.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include<immintrin.h>
+#endif
+
+static int detect()
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if(__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+    return SIMD_NONE;
+}
+
+static int cpu(detect());// best instruction set
+static int level(cpu);// instruction set in use
+
+int SimdLevel() { return level; }
+
+void SetSimdLevel(int l) { level = MIN(l,cpu); }
+
+template<class T>
+static void butterfly1(T *c, T *d, const T *a, const T *b, int n)
+{
+    for(int i=0; i<n; i++) {
+        T x(a[i]);
+        c[i] = x + b[i];
+        d[i] = x + b[i+1];
+    }
+}
+
+template<class T>
+static void sum1(T *c, const T *a, const T *b, int n)
+{
+    for(int i=0; i<n; i++) c[i] = a[i] + b[i];
+}
+
+template<class T>
+static void butterfly4_1(T **c, const T *x0, const T *x1,
+                         const T *x2, const T *x3, int n)
+{
+    for(int i=0; i<n; i++) {
+        T y0(x0[i] + x1[i]), y1(x0[i] + x1[i+1]);
+        c[0][i] = y0 + (x2[i]   + x3[i]);
+        c[1][i] = y0 + (x2[i+1] + x3[i+1]);
+        c[2][i] = y1 + (x2[i+1] + x3[i+2]);
+        c[3][i] = y1 + (x2[i+2] + x3[i+3]);
+    }
+}
+
+#ifdef SIMD_X86
+__attribute__((target("avx2")))
+static void butterfly256(double *c, double *d, const double *a, const double *b, int n)
+{
+    int i;
+    for(i=0; i+4<=n; i+=4) {
+        __m256d x(_mm256_loadu_pd(a+i));
+        __m256d y(_mm256_loadu_pd(b+i));
+        __m256d z(_mm256_loadu_pd(b+i+1));
+        _mm256_storeu_pd(c+i, _mm256_add_pd(x,y));
+        _mm256_storeu_pd(d+i, _mm256_add_pd(x,z));
+    }
+    butterfly1(c+i, d+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx2")))
+static void butterfly256(float *c, float *d, const float *a, const float *b, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8) {
+        __m256 x(_mm256_loadu_ps(a+i));
+        __m256 y(_mm256_loadu_ps(b+i));
+        __m256 z(_mm256_loadu_ps(b+i+1));
+        _mm256_storeu_ps(c+i, _mm256_add_ps(x,y));
+        _mm256_storeu_ps(d+i, _mm256_add_ps(x,z));
+    }
+    butterfly1(c+i, d+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void butterfly512(double *c, double *d, const double *a, const double *b, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8) {
+        __m512d x(_mm512_loadu_pd(a+i));
+        __m512d y(_mm512_loadu_pd(b+i));
+        __m512d z(_mm512_loadu_pd(b+i+1));
+        _mm512_storeu_pd(c+i, _mm512_add_pd(x,y));
+        _mm512_storeu_pd(d+i, _mm512_add_pd(x,z));
+    }
+    butterfly1(c+i, d+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void butterfly512(float *c, float *d, const float *a, const float *b, int n)
+{
+    int i;
+    for(i=0; i+16<=n; i+=16) {
+        __m512 x(_mm512_loadu_ps(a+i));
+        __m512 y(_mm512_loadu_ps(b+i));
+        __m512 z(_mm512_loadu_ps(b+i+1));
+        _mm512_storeu_ps(c+i, _mm512_add_ps(x,y));
+        _mm512_storeu_ps(d+i, _mm512_add_ps(x,z));
+    }
+    butterfly1(c+i, d+i, a+i, b+i, n-i);
+}
+__attribute__((target("avx2")))
+static void sum256(double *c, const double *a, const double *b, int n)
+{
+    int i;
+    for(i=0; i+4<=n; i+=4)
+        _mm256_storeu_pd(c+i, _mm256_add_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i)));
+    sum1(c+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx2")))
+static void sum256(float *c, const float *a, const float *b, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8)
+        _mm256_storeu_ps(c+i, _mm256_add_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i)));
+    sum1(c+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void sum512(double *c, const double *a, const double *b, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8)
+        _mm512_storeu_pd(c+i, _mm512_add_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i)));
+    sum1(c+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void sum512(float *c, const float *a, const float *b, int n)
+{
+    int i;
+    for(i=0; i+16<=n; i+=16)
+        _mm512_storeu_ps(c+i, _mm512_add_ps(_mm512_loadu_ps(a+i), _mm512_loadu_ps(b+i)));
+    sum1(c+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx2")))
+static void butterfly4_256(double **c, const double *x0, const double *x1,
+                           const double *x2, const double *x3, int n)
+{
+    int i;
+    for(i=0; i+4<=n; i+=4) {
+        __m256d a(_mm256_loadu_pd(x0+i));
+        __m256d y0(_mm256_add_pd(a, _mm256_loadu_pd(x1+i)));
+        __m256d y1(_mm256_add_pd(a, _mm256_loadu_pd(x1+i+1)));
+        __m256d b0(_mm256_loadu_pd(x2+i));
+        __m256d b1(_mm256_loadu_pd(x2+i+1));
+        __m256d b2(_mm256_loadu_pd(x2+i+2));
+        _mm256_storeu_pd(c[0]+i, _mm256_add_pd(y0, _mm256_add_pd(b0, _mm256_loadu_pd(x3+i))));
+        _mm256_storeu_pd(c[1]+i, _mm256_add_pd(y0, _mm256_add_pd(b1, _mm256_loadu_pd(x3+i+1))));
+        _mm256_storeu_pd(c[2]+i, _mm256_add_pd(y1, _mm256_add_pd(b1, _mm256_loadu_pd(x3+i+2))));
+        _mm256_storeu_pd(c[3]+i, _mm256_add_pd(y1, _mm256_add_pd(b2, _mm256_loadu_pd(x3+i+3))));
+    }
+    double *d[4] = {c[0]+i, c[1]+i, c[2]+i, c[3]+i};
+    butterfly4_1(d, x0+i, x1+i, x2+i, x3+i, n-i);
+}
+
+__attribute__((target("avx2")))
+static void butterfly4_256(float **c, const float *x0, const float *x1,
+                           const float *x2, const float *x3, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8) {
+        __m256 a(_mm256_loadu_ps(x0+i));
+        __m256 y0(_mm256_add_ps(a, _mm256_loadu_ps(x1+i)));
+        __m256 y1(_mm256_add_ps(a, _mm256_loadu_ps(x1+i+1)));
+        __m256 b0(_mm256_loadu_ps(x2+i));
+        __m256 b1(_mm256_loadu_ps(x2+i+1));
+        __m256 b2(_mm256_loadu_ps(x2+i+2));
+        _mm256_storeu_ps(c[0]+i, _mm256_add_ps(y0, _mm256_add_ps(b0, _mm256_loadu_ps(x3+i))));
+        _mm256_storeu_ps(c[1]+i, _mm256_add_ps(y0, _mm256_add_ps(b1, _mm256_loadu_ps(x3+i+1))));
+        _mm256_storeu_ps(c[2]+i, _mm256_add_ps(y1, _mm256_add_ps(b1, _mm256_loadu_ps(x3+i+2))));
+        _mm256_storeu_ps(c[3]+i, _mm256_add_ps(y1, _mm256_add_ps(b2, _mm256_loadu_ps(x3+i+3))));
+    }
+    float *d[4] = {c[0]+i, c[1]+i, c[2]+i, c[3]+i};
+    butterfly4_1(d, x0+i, x1+i, x2+i, x3+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void butterfly4_512(double **c, const double *x0, const double *x1,
+                           const double *x2, const double *x3, int n)
+{
+    int i;
+    for(i=0; i+8<=n; i+=8) {
+        __m512d a(_mm512_loadu_pd(x0+i));
+        __m512d y0(_mm512_add_pd(a, _mm512_loadu_pd(x1+i)));
+        __m512d y1(_mm512_add_pd(a, _mm512_loadu_pd(x1+i+1)));
+        __m512d b0(_mm512_loadu_pd(x2+i));
+        __m512d b1(_mm512_loadu_pd(x2+i+1));
+        __m512d b2(_mm512_loadu_pd(x2+i+2));
+        _mm512_storeu_pd(c[0]+i, _mm512_add_pd(y0, _mm512_add_pd(b0, _mm512_loadu_pd(x3+i))));
+        _mm512_storeu_pd(c[1]+i, _mm512_add_pd(y0, _mm512_add_pd(b1, _mm512_loadu_pd(x3+i+1))));
+        _mm512_storeu_pd(c[2]+i, _mm512_add_pd(y1, _mm512_add_pd(b1, _mm512_loadu_pd(x3+i+2))));
+        _mm512_storeu_pd(c[3]+i, _mm512_add_pd(y1, _mm512_add_pd(b2, _mm512_loadu_pd(x3+i+3))));
+    }
+    double *d[4] = {c[0]+i, c[1]+i, c[2]+i, c[3]+i};
+    butterfly4_1(d, x0+i, x1+i, x2+i, x3+i, n-i);
+}
+
+__attribute__((target("avx512f")))
+static void butterfly4_512(float **c, const float *x0, const float *x1,
+                           const float *x2, const float *x3, int n)
+{
+    int i;
+    for(i=0; i+16<=n; i+=16) {
+        __m512 a(_mm512_loadu_ps(x0+i));
+        __m512 y0(_mm512_add_ps(a, _mm512_loadu_ps(x1+i)));
+        __m512 y1(_mm512_add_ps(a, _mm512_loadu_ps(x1+i+1)));
+        __m512 b0(_mm512_loadu_ps(x2+i));
+        __m512 b1(_mm512_loadu_ps(x2+i+1));
+        __m512 b2(_mm512_loadu_ps(x2+i+2));
+        _mm512_storeu_ps(c[0]+i, _mm512_add_ps(y0, _mm512_add_ps(b0, _mm512_loadu_ps(x3+i))));
+        _mm512_storeu_ps(c[1]+i, _mm512_add_ps(y0, _mm512_add_ps(b1, _mm512_loadu_ps(x3+i+1))));
+        _mm512_storeu_ps(c[2]+i, _mm512_add_ps(y1, _mm512_add_ps(b1, _mm512_loadu_ps(x3+i+2))));
+        _mm512_storeu_ps(c[3]+i, _mm512_add_ps(y1, _mm512_add_ps(b2, _mm512_loadu_ps(x3+i+3))));
+    }
+    float *d[4] = {c[0]+i, c[1]+i, c[2]+i, c[3]+i};
+    butterfly4_1(d, x0+i, x1+i, x2+i, x3+i, n-i);
+}
+#endif
+
+template<class T>
+static T *scratch(int n)
+// work space of each thread (at least n elements)
+{
+    thread_local Vec<T> s;
+    if(s.size() < n) s.SetLength(n);
+    return &s[0];
+}
+
+template<class T>
+void butterfly(T *c, T *d, const T *a, const T *b, int n)
+// c[i] = a[i] + b[i], d[i] = a[i] + b[i+1] for 0<=i<n
+//   c==a or d==a is allowed; otherwise no overlap
+{
+    switch(level) {
+#ifdef SIMD_X86
+    case SIMD_AVX512: butterfly512(c,d,a,b,n); break;
+    case SIMD_AVX2: butterfly256(c,d,a,b,n); break;
+#endif
+    default: butterfly1(c,d,a,b,n);
+    }
+}
+
+template<class T>
+void sum(T *c, const T *a, const T *b, int n)
+// c[i] = a[i] + b[i] for 0<=i<n (c must not overlap a,b)
+{
+    switch(level) {
+#ifdef SIMD_X86
+    case SIMD_AVX512: sum512(c,a,b,n); break;
+    case SIMD_AVX2: sum256(c,a,b,n); break;
+#endif
+    default: sum1(c,a,b,n);
+    }
+}
+
+template<class T>
+void butterfly4(T **c, const T *x0, const T *x1,
+                const T *x2, const T *x3, int n)
+// two steps of butterfly fused (for 0<=i<n):
+//   c[0][i] = (x0[i] + x1[i]  ) + (x2[i]   + x3[i]  )
+//   c[1][i] = (x0[i] + x1[i]  ) + (x2[i+1] + x3[i+1])
+//   c[2][i] = (x0[i] + x1[i+1]) + (x2[i+1] + x3[i+2])
+//   c[3][i] = (x0[i] + x1[i+1]) + (x2[i+2] + x3[i+3])
+//   c must not overlap x
+{
+    switch(level) {
+#ifdef SIMD_X86
+    case SIMD_AVX512: butterfly4_512(c,x0,x1,x2,x3,n); break;
+    case SIMD_AVX2: butterfly4_256(c,x0,x1,x2,x3,n); break;
+#endif
+    default: butterfly4_1(c,x0,x1,x2,x3,n);
+    }
+}
+
+template<class T>
+void ScanStep(Mat<T>& d, const Mat<T>& s, int h, int y, int k0, int k1)
+// one step of scan in FastCT.cpp from s to d
+//   for columns y+2k and y+2k+1 of d (k0<=k<k1)
+//   d[y+j,i] = s[y+k,i] + s[y+h/2+k,i-l] for m>i>=l
+//              s[y+k,i]                  for l>i>=0
+//   where 0<=j<h, k=j/2, l=(j+1)/2 and m = s.nrows()+h
+// rows i>=m of d are not changed
+{
+    int i,k,m(s.nrows()+h),h1(h>>1);
+    T *c,*e;
+    const T *L,*R;
+    for(k=k0; k<k1; k++) {
+        L = s[y+k];
+        R = s[y+h1+k];
+        c = d[y+2*k];// j = 2k, l = k
+        e = d[y+2*k+1];// j = 2k+1, l = k+1
+        butterfly(e+k+1, c+k+1, L+k+1, R, m-k-1);
+        c[k] = L[k] + R[0];
+        e[k] = L[k];
+        for(i=0; i<k; i++) c[i] = e[i] = L[i];
+    }
+}
+
+template<class T>
+void BackScanStep(Mat<T>& d, const Mat<T>& s, int h, int y, int k0, int k1)
+// one step of BackScan in FastCT.cpp from s to d
+//   for columns y+2k and y+2k+1 of d (k0<=k<k1)
+//   d[y+j,i] = s[y+k,i] + s[y+h/2+k,i+l] for 0<=i<m
+//   where 0<=j<h, k=j/2, l=(j+1)/2 and m = s.ncols()-h
+// rows i>=m of d are not changed
+{
+    int k,m(s.ncols()-h),h1(h>>1);
+    for(k=k0; k<k1; k++)
+        butterfly(d[y+2*k], d[y+2*k+1], s[y+k], s[y+h1+k]+k, m);
+}
+
+template<class T>
+void AdjointStep(Mat<T>& d, const Mat<T>& s, int h, int y, int k0, int k1)
+// transpose of ScanStep(s,d,h,y,k0,k1) from s to d
+//   for columns y+k and y+h/2+k of d (k0<=k<k1)
+//   d[y+k,i]     = s[y+2k,i]   + s[y+2k+1,i]
+//   d[y+h/2+k,i] = s[y+2k,i+k] + s[y+2k+1,i+k+1]
+//   where terms outside 0<=i<m are zero (m = s.ncols())
+{
+    int i,k,m(s.ncols()),h1(h>>1);
+    T *c,*e;
+    const T *L,*R;
+    for(k=k0; k<k1; k++) {
+        L = s[y+2*k];
+        R = s[y+2*k+1];
+        c = d[y+k];
+        e = d[y+h1+k];
+        sum(c, L, R, m);
+        sum(e, L+k, R+k+1, m-k-1);
+        e[m-k-1] = L[m-1];
+        for(i=m-k; i<m; i++) e[i] = 0;
+    }
+}
+
+template<class T>
+void ScanStep4(Mat<T>& d, const Mat<T>& s, int h, int y, int a0, int a1)
+// two steps of scan from s to d fused:
+//   ScanStep(w,s,h/2,...) and then ScanStep(d,w,h,y,...)
+//   for columns y+4a to y+4a+3 of d (a0<=a<a1)
+// missing terms near row 0 are replaced by -0 (x + -0 == x)
+//   to call butterfly4() on padded copies of s
+// rows n<=i<2n of s must be zero (n = s.nrows())
+{
+    int a,i,t,b,m(s.nrows()+h),q(h>>2);
+    const T *x[4];
+    T *c[4],*e[4],*u,*p(scratch<T>(3*(3*q+3)));
+    for(a=a0; a<a1; a++) {
+        b = 3*a+3;// rows where all terms exist start at b
+        for(t=0; t<4; t++) {
+            x[t] = s[y+t*q+a];// term t at row i is x[t][i-t*(a+1)]
+            c[t] = d[y+4*a+3-t];
+            e[t] = c[t] + b;
+        }
+        butterfly4(e, x[0]+b, x[1]+b-(a+1), x[2]+b-2*(a+1), x[3], m-b);
+        for(t=1; t<4; t++) {
+            u = p + (t-1)*(b+3);
+            for(i=0; i<b+3; i++)
+                u[i] = (i<t*(a+1) ? T(-0.) : x[t][i-t*(a+1)]);
+            x[t] = u;
+        }
+        butterfly4(c, x[0], x[1], x[2], x[3], b);
+    }
+}
+
+template<class T>
+void BackScanStep4(Mat<T>& d, const Mat<T>& s, int h, int y, int a0, int a1)
+// two steps of BackScan from s to d fused:
+//   BackScanStep(w,s,h/2,...) and then BackScanStep(d,w,h,y,...)
+//   for columns y+4a to y+4a+3 of d (a0<=a<a1)
+// rows i>=m of d are not meaningful (m = s.ncols()-h)
+{
+    int a,t,m(s.ncols()-h),q(h>>2);
+    T *c[4];
+    for(a=a0; a<a1; a++) {
+        for(t=0; t<4; t++) c[t] = d[y+4*a+t];
+        butterfly4(c, s[y+a], s[y+q+a]+a, s[y+2*q+a]+2*a, s[y+3*q+a]+3*a, m);
+    }
+}
+
+template void butterfly(float*, float*, const float*, const float*, int);
+template void butterfly(double*, double*, const double*, const double*, int);
+template void butterfly4(float**, const float*, const float*,
+                         const float*, const float*, int);
+template void butterfly4(double**, const double*, const double*,
+                         const double*, const double*, int);
+template void ScanStep(Mat_SP&, const Mat_SP&, int, int, int, int);
+template void ScanStep(Mat_DP&, const Mat_DP&, int, int, int, int);
+template void BackScanStep(Mat_SP&, const Mat_SP&, int, int, int, int);
+template void BackScanStep(Mat_DP&, const Mat_DP&, int, int, int, int);
+template void sum(float*, const float*, const float*, int);
+template void sum(double*, const double*, const double*, int);
+template void AdjointStep(Mat_SP&, const Mat_SP&, int, int, int, int);
+template void AdjointStep(Mat_DP&, const Mat_DP&, int, int, int, int);
+template void ScanStep4(Mat_SP&, const Mat_SP&, int, int, int, int);
+template void ScanStep4(Mat_DP&, const Mat_DP&, int, int, int, int);
+template void BackScanStep4(Mat_SP&, const Mat_SP&, int, int, int, int);
+template void BackScanStep4(Mat_DP&, const Mat_DP&, int, int, int, int);
@@ -0,0 +1,159 @@
+// memory mapped file of slices (see DataFile.h)
+
+#include<cstring>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include "DataFile.h"
+#include "nr.h"
+
+DataFile::DataFile() : fd(-1), writable(false), p(0), len(0), h(0) {}
+
+DataFile::~DataFile() { close(); }
+
+long DataFile::bytes() const
+{
+    return long(h->rows)*h->cols*h->dtype;
+}
+
+void DataFile::map(long n)
+// map first n bytes of file (n>0)
+{
+    if(p) munmap(p,len);
+    int prot(writable ? PROT_READ|PROT_WRITE : PROT_READ);
+    void *q(mmap(0, n, prot, MAP_SHARED, fd, 0));
+    if(q==MAP_FAILED) error("DataFile: mmap failed");
+    p = (char*)q;
+    len = n;
+    h = (DataHeader*)p;
+}
+
+void DataFile::create(const char *file_name, int dtype, int rows, int cols,
+                      double spacing, const double *angle, int angles)
+// new file of no slices, opened for append
+// dtype = DATA_FLOAT or DATA_DOUBLE
+// rows,cols = shape of slices
+// spacing = distance between X-rays (or pixels)
+// angle = directions of X-rays (angle[0..angles-1]) if any
+{
+    if(dtype!=DATA_FLOAT && dtype!=DATA_DOUBLE)
+        error("DataFile: bad dtype");
+    close();
+    fd = ::open(file_name, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if(fd<0) error("DataFile: cannot create file");
+    long data(sizeof(DataHeader) + angles*sizeof(double));
+    data = (data + DataPage-1)/DataPage*DataPage;
+    if(ftruncate(fd, data)) error("DataFile: cannot extend file");
+    writable = true;
+    map(data);
+    memcpy(h->magic, DataMagic, sizeof(h->magic));
+    h->version = DataVersion;
+    h->order = DataOrder;
+    h->dtype = dtype;
+    h->rows = rows;
+    h->cols = cols;
+    h->angles = angles;
+    h->slices = 0;
+    h->data = data;
+    h->spacing = spacing;
+    if(angles) memcpy(h+1, angle, angles*sizeof(double));
+}
+
+void DataFile::open(const char *file_name, bool w)
+// w = true if slices are modified or appended
+{
+    close();
+    fd = ::open(file_name, w ? O_RDWR : O_RDONLY);
+    if(fd<0) error("DataFile: cannot open file");
+    struct stat st;
+    if(fstat(fd,&st) || st.st_size < (long)sizeof(DataHeader))
+        error("DataFile: bad file");
+    writable = w;
+    map(st.st_size);
+    if(memcmp(h->magic, DataMagic, sizeof(h->magic)))
+        error("DataFile: not a data file");
+    if(h->version > DataVersion)
+        error("DataFile: unknown version");
+    if(h->order != DataOrder)
+        error("DataFile: byte order differs");
+    if(h->dtype!=DATA_FLOAT && h->dtype!=DATA_DOUBLE)
+        error("DataFile: bad dtype");
+    if(h->data % DataPage || h->data + h->slices*bytes() > len)
+        error("DataFile: file is truncated");
+}
+
+void DataFile::close()
+// file is truncated to its slices if opened for append
+{
+    if(fd<0) return;
+    long n(h->data + h->slices*bytes());
+    munmap(p,len);
+    if(writable && n<len && ftruncate(fd,n))
+        error("DataFile: cannot truncate file");
+    ::close(fd);
+    fd = -1;
+    p = 0;
+    len = 0;
+    h = 0;
+}
+
+template<class T>
+Mat<T> DataFile::slice(long k) const
+// view of slice k backed by the mapped file (no copy)
+// view is valid until append() or close();
+//   it is read-only unless file is opened writable
+{
+    if((int)sizeof(T)!=h->dtype) error("DataFile: dtype differs");
+    if(k<0 || k>=h->slices) error("DataFile: no such slice");
+    return Mat<T>((T*)(p + h->data + k*bytes()), h->rows, h->cols, h->cols);
+}
+
+template<class T>
+void DataFile::read(Mat<T>& A, long k) const
+// copy slice k to A converting dtype if necessary
+{
+    int i,j,m(h->rows),n(h->cols);
+    if(k<0 || k>=h->slices) error("DataFile: no such slice");
+    const char *q(p + h->data + k*bytes());
+    A.SetDims(m,n);
+    if(h->dtype==(int)sizeof(T))
+        for(i=0; i<m; i++) memcpy(A[i], q + long(i)*n*sizeof(T), n*sizeof(T));
+    else if(h->dtype==DATA_FLOAT)
+        for(i=0; i<m; i++) for(j=0; j<n; j++) A[i][j] = ((const float*)q)[long(i)*n+j];
+    else
+        for(i=0; i<m; i++) for(j=0; j<n; j++) A[i][j] = ((const double*)q)[long(i)*n+j];
+}
+
+template<class T>
+void DataFile::append(const Mat<T>& A)
+// add A to the end of slices
+// mapping grows by doubling so that appending is amortized O(1);
+//   views given by slice() are invalidated
+{
+    int i,j,m(h->rows),n(h->cols);
+    if(!writable) error("DataFile: file is read-only");
+    if(A.nrows()!=m || A.ncols()!=n) error("DataFile: shape differs");
+    long b(bytes()), e(h->data + (h->slices+1)*b);
+    if(e > len) {
+        long l(MAX(e, 2*len));
+        l = (l + DataPage-1)/DataPage*DataPage;
+        if(ftruncate(fd,l)) error("DataFile: cannot extend file");
+        map(l);
+    }
+    char *q(p + h->data + h->slices*b);
+    if(h->dtype==(int)sizeof(T))
+        for(i=0; i<m; i++) memcpy(q + long(i)*n*sizeof(T), A[i], n*sizeof(T));
+    else if(h->dtype==DATA_FLOAT)
+        for(i=0; i<m; i++) for(j=0; j<n; j++) ((float*)q)[long(i)*n+j] = A[i][j];
+    else
+        for(i=0; i<m; i++) for(j=0; j<n; j++) ((double*)q)[long(i)*n+j] = A[i][j];
+    h->slices++;
+}
+
+template Mat<float> DataFile::slice(long) const;
+template Mat<double> DataFile::slice(long) const;
+template void DataFile::read(Mat<float>&, long) const;
+template void DataFile::read(Mat<double>&, long) const;
+template void DataFile::append(const Mat<float>&);
+template void DataFile::append(const Mat<double>&);
@@ -0,0 +1,396 @@
+// Fast Fourier Transform with precomputed plan
+//   same conventions as realft() in realft.cpp
+//   W. H. Press, et al, "Numerical Recipes", section 12.3
+// data of nb transforms are interleaved:
+//   data[i*nb+c] = i-th value of c-th transform
+// length n is even and n/2 has no prime factors but 2,3,5;
+//   if n/2 is not power of 2, complex FFT is done by
+//   mixed radix (4,2,3,5) Cooley-Tukey algorithm
+
+#include<cmath>
+#include<mutex>
+#include "FFT.h"
+
+static double PI(atan(1)*4);
+
+static bool smooth(int n)
+// true if n is even and n/2 has no prime factors but 2,3,5
+{
+    if(n<4 || n&1) return false;
+    for(n>>=1; n%2==0; n/=2);
+    for(; n%3==0; n/=3);
+    for(; n%5==0; n/=5);
+    return n==1;
+}
+
+int FFTLength(int n)
+// efficient length of FFT not less than n (and 4):
+//   smallest smooth length, or power of 2 if it is
+//   less than 4/3 of that, since mixed radix costs
+//   about 4/3 as much per point as power of 2
+{
+    int m,p(4);
+    for(m=MAX(n,4); !smooth(m); m++);
+    while(p<m) p<<=1;
+    return 3*p < 4*m ? p : m;
+}
+
+template<class T>
+FFT<T>::FFT(int n1) : n(n1)
+// n1 = length of real data (n1/2 has no prime factors
+//   but 2,3,5; FFTLength gives such length)
+{
+    if(!smooth(n)) error("bad length of FFT");
+    int i,j,k,m,l(n>>1);// l = length of complex FFT
+    u.SetLength((l+1)&~1);// exp(i*2pi*j/n) for 0<=j<l/2
+    for(j=0; 2*j<l; j++) {
+        u[2*j]   = cos(2*PI*j/n);
+        u[2*j+1] = sin(2*PI*j/n);
+    }
+    if(l&(l-1)) {// mixed radix
+        int p,r,s,q,t[32];
+        for(m=l, k=0; m>1; m/=t[k++])
+            t[k] = (m%4==0 ? 4 : m%2==0 ? 2 : m%3==0 ? 3 : 5);
+        fac.SetLength(k);
+        for(i=0; i<k; i++) fac[i] = t[i];
+        // digit reversal: index d0 + f0*(d1 + f1*(d2 + ...))
+        //   takes data from d(k-1) + f(k-1)*(d(k-2) + ...)
+        Vec_INT to(l);
+        for(i=0; i<l; i++) {
+            for(j=i, r=s=0; s<k; s++) {
+                r = r*fac[s] + j%fac[s];
+                j /= fac[s];
+            }
+            to[i] = r;
+        }
+        for(i=j=0; i<l; i++) {// count cycles
+            for(m=0, r=to[i]; r>i; r=to[r]) m++;
+            if(r==i && m) j += m+2;
+        }
+        cyc.SetLength(j);
+        for(i=j=0; i<l; i++) {// cycle starting at smallest index
+            for(m=0, r=to[i]; r>i; r=to[r]) m++;
+            if(r!=i || m==0) continue;
+            cyc[j++] = m+1;
+            for(r=i; m>=0; m--, r=to[r]) cyc[j++] = r;
+        }
+        for(m=1, q=s=0; s<k; m*=fac[s++]) q += m*(fac[s]-1);
+        w.SetLength(2*q);// exp(i*2pi*j*q/(p*m)) of each stage
+        for(m=1, q=s=0; s<k; m*=p, s++)
+            for(p=fac[s], j=0; j<m; j++)
+                for(r=1; r<p; r++, q+=2) {
+                    w[q]   = cos(2*PI*j*r/(p*m));
+                    w[q+1] = sin(2*PI*j*r/(p*m));
+                }
+        return;
+    }
+    for(i=j=k=0; i<l; i++) {// count swaps
+        if(j>i) k++;
+        for(m=l>>1; m>=1 && (j&m); m>>=1) j ^= m;
+        j |= m;
+    }
+    rev.SetLength(2*k);
+    for(i=j=k=0; i<l; i++) {
+        if(j>i) { rev[k++] = i; rev[k++] = j; }
+        for(m=l>>1; m>=1 && (j&m); m>>=1) j ^= m;
+        j |= m;
+    }
+    w.SetLength(2*l);// exp(i*pi*j/m) for 0<=j<m at offset 2m
+    for(m=1; m<l; m<<=1)
+        for(j=0; j<m; j++) {
+            w[2*(m+j)]   = cos(PI*j/m);
+            w[2*(m+j)+1] = sin(PI*j/m);
+        }
+}
+
+template<class T>
+void FFT<T>::four1(T *data, int nb, int isign) const
+// complex FFT of length n/2 (bit reversal and butterflies)
+//   two radix-2 stages are fused into one radix-4 pass
+{
+    int i,j,k,c,m,l(n>>1),nb2(nb*2);
+    T s(isign),ar,ai,br,bi,cr,ci,dr,di,tr,ti;
+    T w1r,w1i,w2r,w2i,w3r,w3i;
+    T *a,*b,*d,*e;
+    if(fac.size()) { mixed(data,nb,isign); return; }
+    for(i=0; i<rev.size(); i+=2) {
+        a = data + rev[i]*nb2;
+        b = data + rev[i+1]*nb2;
+        for(c=0; c<nb2; c++) SWAP(a[c],b[c]);
+    }
+    m = 1;
+    if(__builtin_ctz(l)&1) {// radix-2 stage
+        for(i=0; i<l; i+=2) {
+            a = data + i*nb2;
+            b = a + nb2;
+            for(c=0; c<nb2; c++) {
+                tr = b[c];
+                b[c] = a[c] - tr;
+                a[c] += tr;
+            }
+        }
+        m = 2;
+    }
+    for(; m<l; m<<=2) {// radix-4 stages (m and 2m)
+        for(j=0; j<m; j++) {
+            w1r = w[2*(m+j)];   w1i = s*w[2*(m+j)+1];
+            w2r = w[4*m+2*j];   w2i = s*w[4*m+2*j+1];
+            w3r = w[4*m+2*(j+m)]; w3i = s*w[4*m+2*(j+m)+1];
+            for(k=j; k<l; k+=4*m) {
+                a = data + k*nb2;
+                b = a + m*nb2;
+                d = b + m*nb2;
+                e = d + m*nb2;
+                for(c=0; c<nb; c++) {
+                    // stage m
+                    tr = w1r*b[c] - w1i*b[c+nb];
+                    ti = w1r*b[c+nb] + w1i*b[c];
+                    br = a[c] - tr;    bi = a[c+nb] - ti;
+                    ar = a[c] + tr;    ai = a[c+nb] + ti;
+                    tr = w1r*e[c] - w1i*e[c+nb];
+                    ti = w1r*e[c+nb] + w1i*e[c];
+                    dr = d[c] - tr;    di = d[c+nb] - ti;
+                    cr = d[c] + tr;    ci = d[c+nb] + ti;
+                    // stage 2m
+                    tr = w2r*cr - w2i*ci;
+                    ti = w2r*ci + w2i*cr;
+                    a[c] = ar + tr;    a[c+nb] = ai + ti;
+                    d[c] = ar - tr;    d[c+nb] = ai - ti;
+                    tr = w3r*dr - w3i*di;
+                    ti = w3r*di + w3i*dr;
+                    b[c] = br + tr;    b[c+nb] = bi + ti;
+                    e[c] = br - tr;    e[c+nb] = bi - ti;
+                }
+            }
+        }
+    }
+}
+
+template<class T>
+void FFT<T>::mixed(T *data, int nb, int isign) const
+// complex FFT of length n/2 (digit reversal and butterflies
+//   of radix p = fac[s] on spans m = fac[0]*...*fac[s-1])
+{
+    static const double C3(-0.5), S3(sqrt(0.75));
+    static const double C51(cos(2*PI/5)), C52(cos(4*PI/5));
+    static const double S51(sin(2*PI/5)), S52(sin(4*PI/5));
+    int i,j,k,c,m,p,s,l(n>>1),nb2(nb*2);
+    T g(isign),wr[5],wi[5],zr[5],zi[5];
+    const T *x;
+    T *a[5];
+    thread_local Vec<T> v;// scratch reused by each thread
+    if(v.size() < nb2) v.SetLength(nb2);
+    for(i=0; i<cyc.size(); i+=cyc[i]+1) {// a[c0] = a[c1] = ... = a[c0]
+        const int *q(&cyc[i+1]);
+        int L(cyc[i]);
+        for(c=0; c<nb2; c++) v[c] = data[q[0]*nb2+c];
+        for(j=0; j<L-1; j++)
+            for(c=0; c<nb2; c++) data[q[j]*nb2+c] = data[q[j+1]*nb2+c];
+        for(c=0; c<nb2; c++) data[q[L-1]*nb2+c] = v[c];
+    }
+    for(m=1, x=&w[0], s=0; s<fac.size(); m*=p, s++) {
+        p = fac[s];
+        for(j=0; j<m; j++, x+=2*(p-1)) {
+            wr[0] = 1; wi[0] = 0;
+            for(k=1; k<p; k++) { wr[k] = x[2*k-2]; wi[k] = g*x[2*k-1]; }
+            for(k=j; k<l; k+=p*m) {
+                for(i=0; i<p; i++) a[i] = data + (k+i*m)*nb2;
+                for(c=0; c<nb; c++) {
+                    zr[0] = a[0][c]; zi[0] = a[0][c+nb];
+                    for(i=1; i<p; i++) {
+                        zr[i] = wr[i]*a[i][c] - wi[i]*a[i][c+nb];
+                        zi[i] = wr[i]*a[i][c+nb] + wi[i]*a[i][c];
+                    }
+                    switch(p) {
+                    case 2:
+                        a[0][c] = zr[0] + zr[1]; a[0][c+nb] = zi[0] + zi[1];
+                        a[1][c] = zr[0] - zr[1]; a[1][c+nb] = zi[0] - zi[1];
+                        break;
+                    case 4: {
+                        T ar(zr[0]+zr[2]), ai(zi[0]+zi[2]);
+                        T br(zr[0]-zr[2]), bi(zi[0]-zi[2]);
+                        T cr(zr[1]+zr[3]), ci(zi[1]+zi[3]);
+                        T dr(-g*(zi[1]-zi[3])), di(g*(zr[1]-zr[3]));// i*g*(z1-z3)
+                        a[0][c] = ar + cr; a[0][c+nb] = ai + ci;
+                        a[1][c] = br + dr; a[1][c+nb] = bi + di;
+                        a[2][c] = ar - cr; a[2][c+nb] = ai - ci;
+                        a[3][c] = br - dr; a[3][c+nb] = bi - di;
+                        break;
+                    }
+                    case 3: {
+                        T sr(zr[1]+zr[2]), si(zi[1]+zi[2]);
+                        T mr(zr[0] + C3*sr), mi(zi[0] + C3*si);
+                        T dr(-g*S3*(zi[1]-zi[2])), di(g*S3*(zr[1]-zr[2]));
+                        a[0][c] = zr[0] + sr; a[0][c+nb] = zi[0] + si;
+                        a[1][c] = mr + dr; a[1][c+nb] = mi + di;
+                        a[2][c] = mr - dr; a[2][c+nb] = mi - di;
+                        break;
+                    }
+                    case 5: {
+                        T t1r(zr[1]+zr[4]), t1i(zi[1]+zi[4]);
+                        T t2r(zr[2]+zr[3]), t2i(zi[2]+zi[3]);
+                        T d1r(zr[1]-zr[4]), d1i(zi[1]-zi[4]);
+                        T d2r(zr[2]-zr[3]), d2i(zi[2]-zi[3]);
+                        T a1r(zr[0] + C51*t1r + C52*t2r), a1i(zi[0] + C51*t1i + C52*t2i);
+                        T a2r(zr[0] + C52*t1r + C51*t2r), a2i(zi[0] + C52*t1i + C51*t2i);
+                        // b = i*g*(...)
+                        T b1r(-g*(S51*d1i + S52*d2i)), b1i(g*(S51*d1r + S52*d2r));
+                        T b2r(-g*(S52*d1i - S51*d2i)), b2i(g*(S52*d1r - S51*d2r));
+                        a[0][c] = zr[0] + t1r + t2r; a[0][c+nb] = zi[0] + t1i + t2i;
+                        a[1][c] = a1r + b1r; a[1][c+nb] = a1i + b1i;
+                        a[4][c] = a1r - b1r; a[4][c+nb] = a1i - b1i;
+                        a[2][c] = a2r + b2r; a[2][c+nb] = a2i + b2i;
+                        a[3][c] = a2r - b2r; a[3][c+nb] = a2i - b2i;
+                    }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<class T>
+void FFT<T>::post(T *data, int nb, int isign) const
+// separate FFT of real data from complex FFT of length n/2
+{
+    int i,c;
+    T h1r,h1i,h2r,h2i,wr,wi,c1(0.5),c2(-0.5*isign);
+    T *a,*b,*x,*y;
+    for(i=1; 4*i<n; i++) {
+        wr = u[2*i];
+        wi = isign*u[2*i+1];
+        a = data + 2*i*nb;   b = a + nb;
+        x = data + (n-2*i)*nb; y = x + nb;
+        for(c=0; c<nb; c++) {
+            h1r = c1*(a[c]+x[c]);
+            h1i = c1*(b[c]-y[c]);
+            h2r = -c2*(b[c]+y[c]);
+            h2i = c2*(a[c]-x[c]);
+            a[c] = h1r + wr*h2r - wi*h2i;
+            b[c] = h1i + wr*h2i + wi*h2r;
+            x[c] = h1r - wr*h2r + wi*h2i;
+            y[c] = -h1i + wr*h2i + wi*h2r;
+        }
+    }
+}
+
+template<class T>
+void FFT<T>::forward(T *data, int nb) const
+// same as realft(data,n,nb,1)
+{
+    T t,*b(data+nb);
+    four1(data,nb,1);
+    post(data,nb,1);
+    for(int c=0; c<nb; c++) {
+        t = data[c];
+        data[c] = t + b[c];
+        b[c] = t - b[c];
+    }
+}
+
+template<class T>
+void FFT<T>::inverse(T *data, int nb) const
+// same as realft(data,n,nb,-1)
+{
+    T t,c1(0.5),*b(data+nb);
+    post(data,nb,-1);
+    for(int c=0; c<nb; c++) {
+        t = data[c];
+        data[c] = c1*(t + b[c]);
+        b[c] = c1*(t - b[c]);
+    }
+    four1(data,nb,-1);
+}
+
+template<class T>
+Filter<T>::Filter(int n1, int w, double c) : n(n1), window(w), cutoff(c)
+// n1 = length of FFT
+// w = window multiplied to ramp filter |f|
+//   RAMP: 1
+//   SHEPP_LOGAN: sinc(x/2)
+//   COSINE: cos(pi*x/2)
+//   HAMMING: 0.54 + 0.46*cos(pi*x)
+//   HANN: (1 + cos(pi*x))/2
+//   where x = f/(cutoff*Nyquist frequency)
+// c = cutoff (0<c<=1); response is zero for x>1
+{
+    int i;
+    double x,y;
+    if(!(c>0 && c<=1)) error("cutoff must be in (0,1]");
+    h.SetLength(n);// in order of output of FFT::forward()
+    for(i=0; i<n; i++) {
+        x = (i==1 ? n : i&~1)/(c*n);// i-th frequency / cutoff
+        if(x>1) { h[i] = 0; continue; }
+        switch(window) {
+        case RAMP: y = 1; break;
+        case SHEPP_LOGAN: y = (x==0 ? 1 : sin(PI*x/2)/(PI*x/2)); break;
+        case COSINE: y = cos(PI*x/2); break;
+        case HAMMING: y = 0.54 + 0.46*cos(PI*x); break;
+        case HANN: y = (1 + cos(PI*x))/2; break;
+        default: error("unknown filter");
+        }
+        // ramp filter times normalization 2/n of inverse FFT
+        h[i] = (i==1 ? PI/n : (i>>1)*2*PI/n/n)*y;
+    }
+}
+
+template<class T>
+void Filter<T>::apply(T *data, int nb) const
+// multiply output of FFT::forward() by frequency response
+{
+    for(int i=0; i<n; i++, data+=nb)
+        for(int c=0; c<nb; c++) data[c] *= h[i];
+}
+
+template<class T>
+const FFT<T>& GetFFT(int n)
+// plan of length n created on first use and cached
+{
+    static FFT<T> *plan[32];// powers of 2
+    static FFT<T> **f(0);// others
+    static int nf(0);
+    static std::mutex m;
+    int i;
+    std::lock_guard<std::mutex> l(m);
+    if(n>0 && (n&(n-1))==0) {
+        int k(__builtin_ctz(n));
+        if(plan[k]==0) plan[k] = new FFT<T>(n);
+        return *plan[k];
+    }
+    for(i=0; i<nf; i++) if(f[i]->size()==n) return *f[i];
+    if((nf&(nf-1))==0) {// double capacity
+        FFT<T> **g(new FFT<T>*[nf ? 2*nf : 1]);
+        for(i=0; i<nf; i++) g[i] = f[i];
+        delete[] f;
+        f = g;
+    }
+    return *(f[nf++] = new FFT<T>(n));
+}
+
+template<class T>
+const Filter<T>& GetFilter(int n, int window, double cutoff)
+// filter created on first use and cached
+{
+    static Filter<T> **f(0);
+    static int nf(0);
+    static std::mutex m;
+    int i;
+    std::lock_guard<std::mutex> l(m);
+    for(i=0; i<nf; i++) if(f[i]->is(n,window,cutoff)) return *f[i];
+    if((nf&(nf-1))==0) {// double capacity
+        Filter<T> **g(new Filter<T>*[nf ? 2*nf : 1]);
+        for(i=0; i<nf; i++) g[i] = f[i];
+        delete[] f;
+        f = g;
+    }
+    return *(f[nf++] = new Filter<T>(n,window,cutoff));
+}
+
+template class FFT<float>;
+template class FFT<double>;
+template class Filter<float>;
+template class Filter<double>;
+template const FFT<float>& GetFFT(int);
+template const FFT<double>& GetFFT(int);
+template const Filter<float>& GetFilter(int, int, double);
+template const Filter<double>& GetFilter(int, int, double);
@@ -0,0 +1,187 @@
+// direct Fourier reconstruction by gridding
+// projections are Fourier transformed along r, which by the
+//   Fourier slice theorem gives the 2D Fourier transform of
+//   the image on polar grid; the polar samples are weighted
+//   by their area (density compensation), convolved with
+//   Kaiser-Bessel kernel onto Cartesian grid oversampled by 2,
+//   transformed by one 2D inverse FFT, and divided by Fourier
+//   transform of the kernel (deapodization)
+// reference:
+//   P. J. Beatty, D. G. Nishimura and J. M. Pauly, "Rapid
+//     Gridding Reconstruction With a Minimal Oversampling Ratio"
+//     IEEE Transactions on Medical Imaging 24 (2005) 799
+
+#include "Radon.h"
+#include<cmath>
+
+static double PI(atan(1)*4);
+
+static const int KW(6);// width of kernel in grid points
+static const int KL(1024);// table points per grid spacing
+static double beta(PI*sqrt(SQR(KW/2.*1.5) - 0.8));// shape of kernel
+                                    // for oversampling ratio 2
+
+static Vec_DP KaiserBessel()
+// table of kernel C(u) = I0(beta*sqrt(1-(2u/KW)^2))
+//   at u = i/KL (0 <= i <= KW*KL/2)
+{
+    Vec_DP c(KW*KL/2+1);
+    for(int i=0; i<=KW*KL/2; i++) {
+        double x(2.*i/KL/KW);
+        c[i] = std::cyl_bessel_i(0., beta*sqrt(MAX(1-x*x, 0.)));
+    }
+    return c;
+}
+
+static double deapodize(double x, int G)
+// Fourier transform of kernel at pixel x from center
+//   on grid of G points
+{
+    double z(beta*beta - SQR(PI*KW*x/G));
+    if(z > 0) { z = sqrt(z); return KW*sinh(z)/z; }
+    if(z < 0) { z = sqrt(-z); return KW*sin(z)/z; }
+    return KW;
+}
+
+template<class T>
+void FourierReconstruct(Mat<T>& B, const Mat<T>& A)
+// B = image reconstructed from sinogram A by gridding
+// input:
+//   A = sinogram (output of scan() in CT.cpp, shape(n,m))
+//   M,N = B.nrows(),B.ncols()
+//       = height and width of output image
+//   if M==0, M,N are both set to n/2 (same as BackScan)
+// output: B = image restored from A (shape(M,N))
+// cost is O(n*m*KW^2 + G^2 log G) where G = FFTLength
+//   of 2*max(M,N)
+{
+    static const Vec_DP C(KaiserBessel());
+    int n(A.nrows()), m(A.ncols());
+    if(B.nrows()==0) B.SetDims(n>>1, n>>1);
+    int M(B.nrows()), N(B.ncols()), G(FFTLength(2*MAX(M,N))), P(FFTLength(2*n)), K(P/2);
+    double X((M-1)/2.), Y((N-1)/2.), R(sqrt(X*X + Y*Y));
+    double dr(2*R/(n-1)), dth(PI/m), c((n-1)/2.);
+    double du(G/(P*dr));// radial spacing in grid points
+    const FFT<T>& F(GetFFT<T>(P));
+    const FFT<T>& H(GetFFT<T>(2*G));
+    // density weights of radial samples k (k=0 is shared
+    //   by all directions) times constant factors times
+    //   phase shift of origin to center c of projection
+    Vec_DP wc(K+1), ws(K+1);
+    double q(dr*dr*SQR(2*PI/(P*dr))*PI/m/(4*PI*PI));
+    for(int k=0; k<=K; k++) {
+        double w((k ? k : 0.25)*q), ph(2*PI*k*c/P);
+        wc[k] = w*cos(ph);
+        ws[k] = w*sin(ph);
+    }
+    // polar spectrum S[j][2k], S[j][2k+1] = real and imaginary
+    //   parts of samples at radius k of direction j
+    Mat<T> S;
+    S.SetDims(m, 2*K+2);
+    parallel_for(m, [&](int j0, int j1) {
+        thread_local Vec<T> v;// scratch reused by each thread
+        if(v.size() < P) v.SetLength(P);
+        for(int j=j0; j<j1; j++) {
+            int i,k;
+            for(i=0; i<n; i++) v[i] = A[i][j];
+            for(; i<P; i++) v[i] = 0;
+            F.forward(&v[0]);// v = sum x_i exp(+2pi i ik/P)
+            for(k=0; k<=K; k++) {
+                double re(k==K ? v[1] : k ? v[2*k] : v[0]);
+                double im(k==K || k==0 ? 0 : -v[2*k+1]);// conjugate
+                S[j][2*k]   = re*wc[k] - im*ws[k];
+                S[j][2*k+1] = re*ws[k] + im*wc[k];
+            }
+        }
+    });
+    double dc(0);// sum of samples at k=0 over directions
+    for(int j=0; j<m; j++) dc += S[j][0];
+    // gridding: each thread makes rows a0<=a<a1 of grid,
+    //   visiting samples in the same order, so that result
+    //   does not depend on number of threads
+    // grid point (a,b) is at h[a*2G + b] (real) and
+    //   h[a*2G + G + b] (imaginary), frequency (a-G/2, b-G/2);
+    //   samples whose kernel crosses edge of grid are dropped
+    Vec<T> h(2*G*G);
+    parallel_for(G, [&](int a0, int a1) {
+        int i,j,k,s,s0,s1,a,b,a2,b2,r(KW/2);
+        double u,v,cu[KW],cv[KW],re,im,e(G/2-r);
+        for(a=a0; a<a1; a++)
+            for(b=0; b<2*G; b++) h[long(a)*2*G+b] = 0;
+        for(j=0; j<m; j++) {
+            double cth(cos(j*dth)*du), sth(sin(j*dth)*du);
+            for(k=-K; k<=K; k++) {
+                if(k==0 && j) continue;// k=0 is taken once
+                u = k*cth;// frequency in grid points
+                v = k*sth;
+                if(fabs(u) >= e || fabs(v) >= e) continue;
+                u += G/2;
+                v += G/2;
+                a2 = int(u) - r + 1;// first row of kernel
+                s0 = MAX(a0-a2, 0);
+                s1 = MIN(a1-a2, KW);
+                if(s0>=s1) continue;
+                if(k==0) { re = dc; im = 0; }
+                else {
+                    re = S[j][2*abs(k)];
+                    im = S[j][2*abs(k)+1]*(k<0 ? -1 : 1);
+                }
+                b2 = int(v) - r + 1;
+                for(s=s0; s<s1; s++) cu[s] = C[int(fabs(a2+s-u)*KL + 0.5)];
+                for(s=0; s<KW; s++) cv[s] = C[int(fabs(b2+s-v)*KL + 0.5)];
+                for(s=s0; s<s1; s++) {
+                    T *p(&h[long(a2+s)*2*G + b2]);
+                    double x(re*cu[s]), y(im*cu[s]);
+                    for(i=0; i<KW; i++) {
+                        p[i]   += x*cv[i];
+                        p[i+G] += y*cv[i];
+                    }
+                }
+            }
+        }
+    });
+    // shift origin to center (X,Y) of image and inverse FFT
+    //   along a, transpose, then along b; frequency offset
+    //   G/2 is compensated by sign (-1)^(i+j) of output
+    Vec<T> g(2*G*G);
+    Vec_DP ca(G), sa(G), cb(G), sb(G);
+    for(int a=0; a<G; a++) {
+        ca[a] = cos(2*PI*(a-G/2)*X/G);
+        sa[a] = -sin(2*PI*(a-G/2)*X/G);
+        cb[a] = cos(2*PI*(a-G/2)*Y/G);
+        sb[a] = -sin(2*PI*(a-G/2)*Y/G);
+    }
+    parallel_for(G, [&](int a0, int a1) {
+        for(int a=a0; a<a1; a++) {
+            T *p(&h[long(a)*2*G]);
+            for(int b=0; b<G; b++) {
+                double cp(ca[a]*cb[b] - sa[a]*sb[b]);
+                double sp(ca[a]*sb[b] + sa[a]*cb[b]);
+                T re(p[b]*cp - p[b+G]*sp), im(p[b]*sp + p[b+G]*cp);
+                p[b] = re;
+                p[b+G] = im;
+            }
+        }
+    });
+    H.complex(&h[0], G, 1);
+    parallel_for(G, [&](int b0, int b1) {
+        for(int b=b0; b<b1; b++)
+            for(int a=0; a<G; a++) {
+                g[long(b)*2*G + a] = h[long(a)*2*G + b];
+                g[long(b)*2*G + G + a] = h[long(a)*2*G + G + b];
+            }
+    });
+    H.complex(&g[0], G, 1);
+    // image at pixel (i,j) is real part of g at (j,i)
+    Vec_DP dx(M), dy(N);
+    for(int i=0; i<M; i++) dx[i] = deapodize(i-X, G);
+    for(int j=0; j<N; j++) dy[j] = deapodize(j-Y, G);
+    parallel_for(M, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int j=0; j<N; j++)
+                B[i][j] = g[long(j)*2*G + i]/(dx[i]*dy[j])*((i+j)&1 ? -1 : 1);
+    });
+}
+
+template void FourierReconstruct(Mat_SP&, const Mat_SP&);
+template void FourierReconstruct(Mat_DP&, const Mat_DP&);
@@ -1,7 +1,7 @@
 // linear interpolation
 // W. H. Press, et al, "Numerical Recipes", section 3.4, 3.6
 
-#include "nr.h"
+#include "Radon.h"
 
 void locate(Vec_I_DP &xx, const DP x, int &j)
 {
@@ -60,3 +60,94 @@ double interp2d(double x1, double y1,
     return (1-u)*(1-v)*z[i][j] + u*(1-v)*z[i+1][j]
     + u*v*z[i+1][j+1] + (1-u)*v*z[i][j+1];
 }
+
+template<class T>
+T interp(double x1, const Grid& x, const T *y, double fill_value)
+// linear interpolation on uniform grid
+// input:
+//   x1 = evaluation point
+//   x = uniform grid (ascending or descending)
+//   y = data points (length x.n)
+// return fill_value if x1 is out of x
+//   (always if x.n<2 as in interp() above)
+{
+    int i;
+    double t((x1 - x.x0)/x.dx);
+    if(x.n<2 || !(t>=0 && t<=x.n-1)) return fill_value;
+    i = int(t);
+    if(i==x.n-1) i--;
+    t -= i;
+    return (1-t)*y[i] + t*y[i+1];
+}
+
+template<class T>
+T interp2d(double x1, double y1,
+           const Grid& x, const Grid& y, const Mat<T>& z,
+           double fill_value)
+// linear interpolation on uniform grid in two dimensions
+// input:
+//   x1,y1 = evaluation point
+//   x,y = uniform grids
+//   z = data points (shape(x.n, y.n))
+// return fill_value if (x1,y1) is out of (x,y)
+//   (always if x.n<2 or y.n<2)
+{
+    int i,j;
+    double u((x1 - x.x0)/x.dx), v((y1 - y.x0)/y.dx);
+    if(x.n<2 || y.n<2 || !(u>=0 && u<=x.n-1 && v>=0 && v<=y.n-1))
+        return fill_value;
+    i = int(u); if(i==x.n-1) i--;
+    j = int(v); if(j==y.n-1) j--;
+    u -= i;
+    v -= j;
+    return (1-u)*(1-v)*z[i][j] + u*(1-v)*z[i+1][j]
+    + u*v*z[i+1][j+1] + (1-u)*v*z[i][j+1];
+}
+
+template<class T>
+void interp2d(T *z1, const double *x1, const double *y1, int n,
+              const Grid& x, const Grid& y, const Mat<T>& z,
+              double fill_value)
+// batch of interpolations on uniform grid in two dimensions
+// input:
+//   x1,y1 = evaluation points (length n)
+//   x,y = uniform grids
+//   z = data points (shape(x.n, y.n))
+// output: z1[k] = interp2d(x1[k], y1[k], x, y, z, fill_value)
+//   for 0<=k<n
+// indices are clamped so that the loop has no branch;
+//   grid of less than 2 points gives fill_value everywhere
+{
+    int i,j,k,m(z.stride());
+    double u,v;
+    double rx(1/x.dx), ry(1/y.dx), nx(x.n-1), ny(y.n-1);
+    T a,b,s,t,f(fill_value);
+    if(x.n<2 || y.n<2) {
+        for(k=0; k<n; k++) z1[k] = f;
+        return;
+    }
+    const T *p(z[0]),*q;
+    for(k=0; k<n; k++) {
+        u = (x1[k] - x.x0)*rx;
+        v = (y1[k] - y.x0)*ry;
+        i = int(MIN(MAX(u,0.), nx-1));
+        j = int(MIN(MAX(v,0.), ny-1));
+        s = u-i;// weights in T
+        t = v-j;
+        q = p + i*m + j;
+        a = (1-t)*q[0] + t*q[1];
+        b = (1-t)*q[m] + t*q[m+1];
+        z1[k] = (u>=0 && u<=nx && v>=0 && v<=ny) ? (1-s)*a + s*b : f;
+    }
+}
+
+template float interp(double, const Grid&, const float*, double);
+template double interp(double, const Grid&, const double*, double);
+template float interp2d(double, double, const Grid&, const Grid&,
+                        const Mat_SP&, double);
+template double interp2d(double, double, const Grid&, const Grid&,
+                         const Mat_DP&, double);
+template void interp2d(float*, const double*, const double*, int,
+                       const Grid&, const Grid&, const Mat_SP&, double);
+template void interp2d(double*, const double*, const double*, int,
+                       const Grid&, const Grid&, const Mat_DP&, double);
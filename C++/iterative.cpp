@@ -0,0 +1,268 @@
+// iterative reconstruction on fast Radon transform:
+//   A is sought so that scan(A) fits data d in least squares,
+//   using scan in FastCT.cpp and its exact transpose ScanAdjoint
+// reference:
+//   A. C. Kak and M. Slaney, "Principles of Computerized
+//     Tomographic Imaging" (IEEE Press, 1988) chapter 7
+//   A. Bjorck, "Numerical Methods for Least Squares Problems"
+//     (SIAM, 1996) section 7.4
+
+#include "Radon.h"
+
+template<class F>
+static double RowSum(Vec_DP& p, int m, const F& f)
+// sum of f(i) for rows 0<=i<m, where rows are done in
+//   parallel and partial sums are added in the order of i,
+//   so that result does not depend on number of threads
+// p = buffer of partial sums (length>=m, kept in Workspace)
+{
+    if(p.size() < m) p.SetLength(m);
+    parallel_for(m, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++) p[i] = f(i);
+    });
+    double s(0);
+    for(int i=0; i<m; i++) s += p[i];
+    return s;
+}
+
+template<class T>
+static inline T *row(RadonT<T>& d, int i)
+// row i of d[0],d[1],d[2],d[3] stacked (0<=i<8n)
+{
+    int n2(d.size()*2);
+    return d[i/n2][i%n2];
+}
+
+template<class T>
+static inline const T *row(const RadonT<T>& d, int i)
+{
+    int n2(d.size()*2);
+    return d[i/n2][i%n2];
+}
+
+template<class T>
+static double residual(RadonT<T>& r, const RadonT<T>& d, const Mat<T>& A,
+                       Workspace<T>& ws)
+// r = d - scan(A); return value = |r|^2
+{
+    int n(d.size());
+    scan(r,A,ws);
+    return RowSum(ws.p, 8*n, [&](int i) {
+        T *p(row(r,i));
+        const T *q(row(d,i));
+        double s(0);
+        for(int j=0; j<n; j++) {
+            p[j] = q[j] - p[j];
+            s += p[j]*p[j];
+        }
+        return s;
+    });
+}
+
+template<class T>
+static double norm(const Mat<T>& A, Workspace<T>& ws)
+// |A|^2
+{
+    int n(A.ncols());
+    return RowSum(ws.p, A.nrows(), [&](int i) {
+        double s(0);
+        for(int j=0; j<n; j++) s += A[i][j]*A[i][j];
+        return s;
+    });
+}
+
+template<class T>
+static double dot(const RadonT<T>& a, const RadonT<T>& b, Workspace<T>& ws)
+// <a,b>
+{
+    int n(a.size());
+    return RowSum(ws.p, 8*n, [&](int i) {
+        const T *p(row(a,i)), *q(row(b,i));
+        double s(0);
+        for(int j=0; j<n; j++) s += p[j]*q[j];
+        return s;
+    });
+}
+
+template<class T>
+static void WarmStart(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws)
+// A = c*reconstruct(d), where c minimizes |d - c*scan(reconstruct(d))|,
+//   since units of d and scale of reconstruct may differ
+{
+    int n(d.size());
+    reconstruct(A,d,ws);
+    scan(ws.r,A,ws);
+    double a(dot(ws.r,d,ws)), b(dot(ws.r,ws.r,ws));
+    T c(b>0 ? a/b : 0);
+    parallel_for(n, [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int j=0; j<n; j++) A[i][j] *= c;
+    });
+}
+
+template<class T>
+static void invert(Mat<T>& A)
+// A = 1/A where A>0, otherwise 0
+{
+    int n(A.ncols());
+    parallel_for(A.nrows(), [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int j=0; j<n; j++)
+                A[i][j] = (A[i][j] > 0 ? 1/A[i][j] : 0);
+    });
+}
+
+template<class T>
+static void clip(Mat<T>& A)
+// A = max(A,0)
+{
+    int n(A.ncols());
+    parallel_for(A.nrows(), [&](int i0, int i1) {
+        for(int i=i0; i<i1; i++)
+            for(int j=0; j<n; j++)
+                if(!(A[i][j] > 0)) A[i][j] = 0;
+    });
+}
+
+template<class T>
+static int sirt(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws,
+                int iter, double tol, bool nonneg)
+// A += C*ScanAdjoint(R*(d - scan(A))) until convergence,
+//   where R,C = inverse of sums of rows and columns
+//   of scan (as matrix), so that each step is a contraction
+{
+    int i,it,n(d.size());
+    RadonT<T>& r(ws.r), &q(ws.q);
+    Mat<T>& u(ws.u), &v(ws.v);
+    // q = R = 1/scan(1), v = C = 1/ScanAdjoint(1)
+    v.SetDims(n,n,T(1));
+    scan(q,v,ws);
+    for(i=0; i<4; i++) invert(q[i]);
+    r.SetSize(n);
+    for(i=0; i<4; i++) r[i].SetDims(2*n,n,T(1));
+    ScanAdjoint(v,r,ws);
+    invert(v);
+    double b(dot(d,d,ws)*tol*tol);
+    for(it=0; it<iter; it++) {
+        if(residual(r,d,A,ws) <= b) break;
+        parallel_for(8*n, [&](int i0, int i1) {
+            for(int i=i0; i<i1; i++) {
+                T *p(row(r,i));
+                const T *w(row(q,i));
+                for(int j=0; j<n; j++) p[j] *= w[j];
+            }
+        });
+        ScanAdjoint(u,r,ws);
+        parallel_for(n, [&](int i0, int i1) {
+            for(int i=i0; i<i1; i++)
+                for(int j=0; j<n; j++) A[i][j] += u[i][j]*v[i][j];
+        });
+        if(nonneg) clip(A);
+    }
+    return it;
+}
+
+template<class T>
+static int cgls(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws,
+                int iter, double tol, bool nonneg)
+// conjugate gradient on normal equation
+//   ScanAdjoint(scan(A)) = ScanAdjoint(d);
+// if nonneg, negative pixels are set to zero after a step
+//   and iteration is restarted from steepest descent
+// iteration stops if scan(v)=0, e.g. for d=0 or exact solution
+{
+    int it,n(d.size());
+    RadonT<T>& r(ws.r), &q(ws.q);
+    Mat<T>& u(ws.u), &v(ws.v);
+    double a,g(0),g1,e(0),b(dot(d,d,ws)*tol*tol);
+    bool restart(true);
+    for(it=0; it<iter; it++) {
+        if(restart) {// r = d - scan(A), u = v = ScanAdjoint(r)
+            e = residual(r,d,A,ws);
+            ScanAdjoint(u,r,ws);
+            v = u;
+            g = norm(u,ws);
+            restart = false;
+        }
+        if(e <= b || g == 0) break;
+        scan(q,v,ws);
+        a = dot(q,q,ws);
+        if(a == 0) break;// v is in null space of scan
+        a = g/a;
+        double c = RowSum(ws.p, n, [&](int i) {
+            int j,k(0);
+            for(j=0; j<n; j++) {
+                A[i][j] += a*v[i][j];
+                k += (A[i][j] < 0);
+            }
+            return double(k);
+        });
+        if(nonneg && c>0) {
+            clip(A);
+            restart = true;
+            continue;
+        }
+        e = RowSum(ws.p, 8*n, [&](int i) {
+            T *p(row(r,i));
+            const T *w(row(q,i));
+            double s(0);
+            for(int j=0; j<n; j++) {
+                p[j] -= a*w[j];
+                s += p[j]*p[j];
+            }
+            return s;
+        });
+        ScanAdjoint(u,r,ws);
+        g1 = norm(u,ws);
+        parallel_for(n, [&](int i0, int i1) {
+            for(int i=i0; i<i1; i++)
+                for(int j=0; j<n; j++) v[i][j] = u[i][j] + g1/g*v[i][j];
+        });
+        g = g1;
+    }
+    return it;
+}
+
+template<class T>
+int solve(Mat<T>& A, const RadonT<T>& d, int method, int iter,
+          double tol, bool nonneg)
+{
+    Workspace<T> ws;
+    return solve(A,d,ws,method,iter,tol,nonneg);
+}
+
+template<class T>
+int solve(Mat<T>& A, const RadonT<T>& d, Workspace<T>& ws,
+          int method, int iter, double tol, bool nonneg)
+// A = least squares solution of scan(A) = d (scan in FastCT.cpp)
+// input:
+//   d = scanned data (shape(4,2n,n)), not filtered;
+//       RadonFromSinogram(d,D) gives scan(A)/dr where
+//       dr = spacing of X-rays in D (see CT.cpp)
+//   A = initial guess (shape(n,n)); if A.nrows()==0,
+//       A is set to reconstruct(A,d) scaled to fit d
+//   ws = work space reused between calls and iterations
+//   method = SIRT or CGLS
+//   iter = maximum number of iterations
+//   tol = iteration stops when |d - scan(A)| <= tol*|d|
+//   nonneg = true if A is constrained to A>=0
+// output: A = solution (shape(n,n))
+//   return value = number of iterations done
+// each iteration costs one scan and one ScanAdjoint
+//   (and one more scan in CGLS when nonneg takes effect);
+//   after first call, no allocation is done in ws
+{
+    int n(d.size());
+    if(A.nrows()==0) WarmStart(A,d,ws);
+    else if(A.nrows()!=n || A.ncols()!=n) error("solve: bad initial guess");
+    if(nonneg) clip(A);
+    if(method==SIRT) return sirt(A,d,ws,iter,tol,nonneg);
+    else if(method==CGLS) return cgls(A,d,ws,iter,tol,nonneg);
+    else error("solve: unknown method");
+    return 0;
+}
+
+template int solve(Mat_SP&, const Radon_SP&, int, int, double, bool);
+template int solve(Mat_DP&, const Radon&, int, int, double, bool);
+template int solve(Mat_SP&, const Radon_SP&, Workspace<float>&, int, int, double, bool);
+template int solve(Mat_DP&, const Radon&, Workspace<double>&, int, int, double, bool);
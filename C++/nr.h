@@ -9,6 +9,7 @@
 #include "Mat.h"
 
 typedef	double DP;
+typedef	float SP;
 
 template<class T>
 inline void SWAP(T& a, T& b) { T c(a); a=b; b=c; }
@@ -0,0 +1,114 @@
+// persistent pool of worker threads for parallel_for()
+
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include "Parallel.h"
+
+static struct Pool {
+    int nt;// number of threads including caller
+    std::thread *w;// worker threads
+    std::mutex busy;// held while parallel region runs
+    std::mutex m;
+    std::condition_variable start,done;
+    void (*f)(void*, int, int);
+    void *arg;
+    int n,todo;
+    long gen;// incremented for each job
+    bool quit;
+    Pool() : nt(0), w(0), todo(0), gen(0), quit(false) {}
+    ~Pool() { stop(); }
+    void run(int, long);
+    void stop();
+    void resize(int);
+} pool;
+
+static thread_local bool inside(false);// running in parallel region
+
+void Pool::run(int k, long g)
+// worker loop of k-th thread
+// g = number of jobs before the thread was made
+{
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> l(m);
+            start.wait(l, [&]{ return quit || gen!=g; });
+            if(quit) return;
+            g = gen;
+        }
+        inside = true;
+        f(arg, int((long)n*k/nt), int((long)n*(k+1)/nt));
+        inside = false;
+        std::lock_guard<std::mutex> l(m);
+        if(--todo==0) done.notify_one();
+    }
+}
+
+void Pool::stop()
+{
+    if(w==0) return;
+    {
+        std::lock_guard<std::mutex> l(m);
+        quit = true;
+    }
+    start.notify_all();
+    for(int k=1; k<nt; k++) w[k-1].join();
+    delete[] w;
+    w = 0;
+    quit = false;
+}
+
+void Pool::resize(int p)
+{
+    std::lock_guard<std::mutex> l(busy);
+    stop();
+    nt = p;
+    if(nt>1) w = new std::thread[nt-1];
+    for(int k=1; k<nt; k++)
+        w[k-1] = std::thread(&Pool::run, this, k, gen);
+}
+
+void SetNumThreads(int p)
+// p = number of threads (p==1 for serial execution)
+//   if p==0, p is set to number of cores
+{
+    if(p<=0) p = std::thread::hardware_concurrency();
+    if(p<=0) p = 1;
+    if(p!=pool.nt) pool.resize(p);
+}
+
+int NumThreads()
+{
+    if(pool.nt==0) SetNumThreads(0);
+    return pool.nt;
+}
+
+void parallel(int n, void (*f)(void*, int, int), void *arg)
+// call f(arg,i0,i1) for NumThreads() ranges [i0,i1)
+// nested call runs serially in caller, and so does a call
+//   from other threads while pool is busy
+{
+    int p(NumThreads());
+    if(n<=0) return;
+    if(p==1 || n==1 || inside || !pool.busy.try_lock()) {
+        f(arg,0,n);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> l(pool.m);
+        pool.f = f;
+        pool.arg = arg;
+        pool.n = n;
+        pool.todo = p-1;
+        pool.gen++;
+    }
+    pool.start.notify_all();
+    inside = true;
+    f(arg, 0, int((long)n/p));
+    inside = false;
+    {
+        std::unique_lock<std::mutex> l(pool.m);
+        pool.done.wait(l, []{ return pool.todo==0; });
+    }
+    pool.busy.unlock();
+}
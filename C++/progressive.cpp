@@ -0,0 +1,54 @@
+// coarse to fine reconstruction (see Progressive.h)
+// image of size n/f (f = 2^l) is restored by BackScan of
+//   filtered data decimated by f: each line of coarse image
+//   is the sum of f lines of fine image that run through
+//   the same coarse pixels, so that coarse image is close
+//   to the average of f by f blocks of full image
+// data are decimated by decimate() in FastCT.cpp
+// coarsest level is decimated from data before filtering,
+//   so that it is shown before data are filtered at full
+//   resolution; finer levels reuse the filtered data
+
+#include "Progressive.h"
+
+template<class T>
+Progressive<T>::Progressive(int levels, int window, double cutoff)
+// levels = number of coarse levels (coarsest is n/2^levels)
+// window, cutoff = see Filter in fft.cpp
+: L(levels), window(window), cutoff(cutoff)
+{
+    if(L<0 || L>MAX_LEVELS) error("Progressive: bad number of levels");
+}
+
+template<class T>
+void Progressive<T>::run(Mat<T>& A, const RadonT<T>& d,
+                         void (*f)(int, const Mat<T>&, void*), void *p)
+// A = reconstruct(A,d,window,cutoff) (identical to it),
+//   calling f(l,B,p) with coarse images B on the way
+// input: d = scanned data (shape(4,2n,n)), n>=2^(levels+1)
+// output: A = restored image (shape(n,n))
+// work of coarse levels is about 1/3 of reconstruct in total
+//   (sum of 4^-l), and arrays are reused between calls of
+//   the same size
+{
+    int l,n(d.size());
+    if((n>>L) < 2) error("Progressive: too many levels");
+    // factor 1/f^2 for f*f pixels of fine image in a coarse
+    //   pixel, and f for ramp filter f times as steep
+    for(l=L; l>0; l--) {
+        if(l==L) {
+            decimate(ws[l].a, d, 1<<l, 1./(1<<2*l));
+            filtering(ws[l].a, ws[l].a, window, cutoff);
+        }
+        else decimate(ws[l].a, ws[0].a, 1<<l, 1./(1<<l));
+        BackScan(B[l], ws[l].a, ws[l]);
+        f(l, B[l], p);
+        if(l==L) filtering(ws[0].a, d, window, cutoff);
+    }
+    if(L==0) filtering(ws[0].a, d, window, cutoff);
+    BackScan(A, ws[0].a, ws[0]);
+    f(0, A, p);
+}
+
+template class Progressive<float>;
+template class Progressive<double>;
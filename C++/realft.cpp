@@ -5,18 +5,25 @@
 #include "nr.h"
 using namespace std;
 
-void four1(Vec_IO_DP &data, const int isign)
+template<class T>
+void four1(T *data, const int n, const int nb, const int isign)
+// batch of nb complex FFTs interleaved in data
+// input:
+//   data[i*nb+c] = i-th real value of c-th transform
+//     (0<=i<n, 0<=c<nb; real and imaginary parts alternate)
+//   n = number of real values of each transform (power of 2)
+// arithmetic for each transform is the same as nb==1
 {
-    int n,mmax,m,j,istep,i;
+    int mmax,m,j,istep,i,c;
     DP wtemp,wr,wpr,wpi,wi,theta,tempr,tempi;
+    T *a,*b,*x,*y;
     
-    int nn=data.size()/2;
-    n=nn << 1;
+    int nn=n/2;
     j=1;
     for (i=1;i<n;i+=2) {
         if (j > i) {
-            SWAP(data[j-1],data[i-1]);
-            SWAP(data[j],data[i]);
+            a=data+(i-1)*nb; x=data+(j-1)*nb;
+            for (c=0;c<2*nb;c++) SWAP(a[c],x[c]);
         }
         m=nn;
         while (m >= 2 && j > m) {
@@ -37,12 +44,16 @@ void four1(Vec_IO_DP &data, const int isign)
         for (m=1;m<mmax;m+=2) {
             for (i=m;i<=n;i+=istep) {
                 j=i+mmax;
-                tempr=wr*data[j-1]-wi*data[j];
-                tempi=wr*data[j]+wi*data[j-1];
-                data[j-1]=data[i-1]-tempr;
-                data[j]=data[i]-tempi;
-                data[i-1] += tempr;
-                data[i] += tempi;
+                a=data+(i-1)*nb; b=a+nb;
+                x=data+(j-1)*nb; y=x+nb;
+                for (c=0;c<nb;c++) {
+                    tempr=wr*x[c]-wi*y[c];
+                    tempi=wr*y[c]+wi*x[c];
+                    x[c]=a[c]-tempr;
+                    y[c]=b[c]-tempi;
+                    a[c] += tempr;
+                    b[c] += tempi;
+                }
             }
             wr=(wtemp=wr)*wpr-wi*wpi+wr;
             wi=wi*wpr+wtemp*wpi+wi;
@@ -51,16 +62,20 @@ void four1(Vec_IO_DP &data, const int isign)
     }
 }
 
-void realft(Vec_IO_DP &data, const int isign)
+template<class T>
+void realft(T *data, const int n, const int nb, const int isign)
+// batch of nb real FFTs interleaved in data
+//   data[i*nb+c] = i-th value of c-th transform (0<=i<n)
+// arithmetic for each transform is the same as nb==1
 {
-    int i,i1,i2,i3,i4;
+    int i,i1,i2,i3,i4,c;
     DP c1=0.5,c2,h1r,h1i,h2r,h2i,wr,wi,wpr,wpi,wtemp,theta;
+    T *a,*b,*x,*y;
     
-    int n=data.size();
     theta=3.141592653589793238/DP(n>>1);
     if (isign == 1) {
         c2 = -0.5;
-        four1(data,1);
+        four1(data,n,nb,1);
     } else {
         c2=0.5;
         theta = -theta;
@@ -73,23 +88,51 @@ void realft(Vec_IO_DP &data, const int isign)
     for (i=1;i<(n>>2);i++) {
         i2=1+(i1=i+i);
         i4=1+(i3=n-i1);
-        h1r=c1*(data[i1]+data[i3]);
-        h1i=c1*(data[i2]-data[i4]);
-        h2r= -c2*(data[i2]+data[i4]);
-        h2i=c2*(data[i1]-data[i3]);
-        data[i1]=h1r+wr*h2r-wi*h2i;
-        data[i2]=h1i+wr*h2i+wi*h2r;
-        data[i3]=h1r-wr*h2r+wi*h2i;
-        data[i4]= -h1i+wr*h2i+wi*h2r;
+        a=data+i1*nb; b=data+i2*nb;
+        x=data+i3*nb; y=data+i4*nb;
+        for (c=0;c<nb;c++) {
+            h1r=c1*(a[c]+x[c]);
+            h1i=c1*(b[c]-y[c]);
+            h2r= -c2*(b[c]+y[c]);
+            h2i=c2*(a[c]-x[c]);
+            a[c]=h1r+wr*h2r-wi*h2i;
+            b[c]=h1i+wr*h2i+wi*h2r;
+            x[c]=h1r-wr*h2r+wi*h2i;
+            y[c]= -h1i+wr*h2i+wi*h2r;
+        }
         wr=(wtemp=wr)*wpr-wi*wpi+wr;
         wi=wi*wpr+wtemp*wpi+wi;
     }
+    a=data; b=data+nb;
     if (isign == 1) {
-        data[0] = (h1r=data[0])+data[1];
-        data[1] = h1r-data[1];
+        for (c=0;c<nb;c++) {
+            a[c] = (h1r=a[c])+b[c];
+            b[c] = h1r-b[c];
+        }
     } else {
-        data[0]=c1*((h1r=data[0])+data[1]);
-        data[1]=c1*(h1r-data[1]);
-        four1(data,-1);
+        for (c=0;c<nb;c++) {
+            a[c]=c1*((h1r=a[c])+b[c]);
+            b[c]=c1*(h1r-b[c]);
+        }
+        four1(data,n,nb,-1);
     }
 }
+
+template<class T>
+void four1(Vec<T> &data, const int isign)
+{
+    four1(&data[0],data.size()/2*2,1,isign);
+}
+
+template<class T>
+void realft(Vec<T> &data, const int isign)
+{
+    realft(&data[0],data.size(),1,isign);
+}
+
+template void four1(Vec_IO_SP&, const int);
+template void four1(Vec_IO_DP&, const int);
+template void realft(Vec_IO_SP&, const int);
+template void realft(Vec_IO_DP&, const int);
+template void realft(float*, const int, const int, const int);
+template void realft(double*, const int, const int, const int);
@@ -0,0 +1,163 @@
+// reconstruction of many slices of the same geometry
+// interpolation indices and weights of RadonFromSinogram and
+//   SinogramFromRadon (FastCT.cpp) are computed once in the
+//   same arithmetic as interp2d (interp.cpp), so that results
+//   are identical to those functions
+
+#include "Reconstructor.h"
+#include<cmath>
+
+static double PI4(atan(1)); // pi/4
+static double PI2(PI4*2);   // pi/2
+static double PI(PI2*2);
+
+template<class P>
+static void stencil(P& p, double x1, double y1, const Grid& x, const Grid& y)
+// p = stencil of interp2d(x1,y1,x,y,z,0) at z[p.i][p.j]
+//   (p.i<0 if (x1,y1) is out of (x,y)); stride of z is
+//   given when applied, so that z may be any view
+{
+    double u((x1 - x.x0)*(1/x.dx)), v((y1 - y.x0)*(1/y.dx));
+    double nx(x.n-1), ny(y.n-1);
+    int i(MIN(MAX(u,0.), nx-1)), j(MIN(MAX(v,0.), ny-1));
+    p.s = u-i;
+    p.t = v-j;
+    p.i = (u>=0 && u<=nx && v>=0 && v<=ny) ? i : -1;
+    p.j = j;
+}
+
+template<class T, class P>
+static inline T apply(const P& p, const T *z, int ld)
+// bilinear interpolation of z (stride ld) by stencil p
+{
+    if(p.i<0) return 0;
+    const T *q(z + p.i*ld + p.j);
+    T a((1-p.t)*q[0] + p.t*q[1]);
+    T b((1-p.t)*q[ld] + p.t*q[ld+1]);
+    return (1-p.s)*a + p.s*b;
+}
+
+template<class T>
+Reconstructor<T>::Reconstructor(int n, int M, int N,
+                                int window, double cutoff)
+// n = image size (power of 2)
+// M = number of directions of X-rays in sinogram
+// N = number of parallel X-rays in sinogram
+// window, cutoff = see Filter in fft.cpp
+// stencils take 8*n*n + M*N points
+: n(n), N(N), M(M), F(GetFFT<T>(n*2)), H(GetFilter<T>(n*2,window,cutoff))
+{
+    int n2(n*2);
+    double n1(n-1), R(n1/sqrt(2));
+    double dr(2*R/(N-1)), dth(PI/M);
+    Grid r(-R,dr,N), th(0,dth,M);// axes of sinogram
+    Grid x(0,1,n2), y(0,1,n);// axes of Radon data
+    rs.SetLength(4*n2*n);
+    rc.SetLength(n);
+    parallel_for(n, [&](int j0, int j1) {
+        int i,j,k;
+        double th1,cth,jn,th2[4];
+        for(j=j0; j<j1; j++) {
+            th1 = atan2(j,n1);// slope
+            cth = cos(th1);
+            jn = (j+n1)/2;
+            th2[0] = th1;
+            th2[1] = PI2-th1;
+            th2[2] = PI2+th1;
+            th2[3] = PI-th1;
+            rc[j] = cth;
+            for(k=0; k<4; k++)
+                for(i=0; i<n2; i++)
+                    stencil(rs[(k*n2+i)*n+j], (i - jn)*cth, th2[k], r, th);
+        }
+    });
+    sr.SetLength(N*M);
+    sc.SetLength(M);
+    sk.SetLength(M);
+    parallel_for(M, [&](int j0, int j1) {
+        int i,j,k;
+        double t,y1,yn;
+        for(j=j0; j<j1; j++) {
+            t = j*dth;
+            k = int(floor(t/PI4));// 0,1,2,3
+            t = (t - PI2*((k+1)>>1))*(k&1 ? -1:1);
+            y1 = n1*tan(t);
+            yn = (y1+n1)/2;
+            sc[j] = 1/cos(t);
+            sk[j] = k;
+            for(i=0; i<N; i++)
+                stencil(sr[i*M+j], (i*dr - R)*sc[j] + yn, y1, x, y);
+        }
+    });
+}
+
+template<class T>
+void Reconstructor<T>::RadonFromSinogram(RadonT<T>& d, const Mat<T>& A) const
+// input: A = sinogram (shape(N,M))
+// output: d = RadonFromSinogram(d,A) in FastCT.cpp
+{
+    int i,n2(n*2);
+    if(A.nrows()!=N || A.ncols()!=M) error("sinogram of wrong size");
+    if(d.size()!=n) d.SetSize(n);
+    parallel_for(4*n2, [&](int l0, int l1) {
+        int l,j,la(A.stride());
+        T *b;
+        const Point *p;
+        for(l=l0; l<l1; l++) {// row i of d[k] (l = k*n2 + i)
+            b = d[l/n2][l%n2];
+            p = &rs[l*n];
+            for(j=0; j<n; j++) b[j] = apply(p[j], A[0], la)*rc[j];
+        }
+    });
+    for(i=0; i<n; i++) d[3][i][0] = d[0][n-1-i][0];
+}
+
+template<class T>
+void Reconstructor<T>::SinogramFromRadon(Mat<T>& A, const RadonT<T>& d) const
+// input: d = Radon data (shape(4,2n,n))
+// output: A = SinogramFromRadon(A,d) in FastCT.cpp (shape(N,M))
+{
+    if(d.size()!=n) error("Radon data of wrong size");
+    A.SetDims(N,M);
+    parallel_for(N, [&](int i0, int i1) {
+        int i,j,ld(d[0].stride());
+        T *a;
+        const Point *p;
+        for(i=i0; i<i1; i++) {
+            a = A[i];
+            p = &sr[i*M];
+            for(j=0; j<M; j++) a[j] = apply(p[j], d[sk[j]][0], ld)*sc[j];
+        }
+    });
+}
+
+template<class T>
+void Reconstructor<T>::filtering(RadonT<T>& d) const
+// high-pass filter applied to d in place
+{
+    if(d.size()!=n) error("Radon data of wrong size");
+    for(int k=0; k<4; k++) ::filtering(d[k], d[k], F, H);
+}
+
+template<class T>
+void Reconstructor<T>::reconstruct(Mat<T>& B, const Mat<T>& A)
+// B = image restored from sinogram A (shape(n,n))
+//   = reconstruct(B,d) after RadonFromSinogram(d,A) in FastCT.cpp
+{
+    RadonFromSinogram(d,A);
+    filtering(d);
+    BackScan(B,d,ws);
+}
+
+template<class T>
+void Reconstructor<T>::project(Mat<T>& A, const Mat<T>& B)
+// A = sinogram of image B (shape(n,n))
+//   = SinogramFromRadon(A,d) after scan(d,B) in FastCT.cpp
+{
+    if(B.nrows()!=n) error("image of wrong size");
+    scan(d,B,ws);
+    SinogramFromRadon(A,d);
+}
+
+template class Reconstructor<float>;
+template class Reconstructor<double>;
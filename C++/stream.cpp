@@ -0,0 +1,134 @@
+// pipelined reconstruction of slices (see Stream.h)
+
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include "Stream.h"
+
+template<class X>
+class Queue {// bounded queue of pointers to buffers
+private:
+    X **q;
+    int n,head,count;
+    bool closed;
+    std::mutex m;
+    std::condition_variable c;
+public:
+    explicit Queue(int k) : q(new X*[k]), n(k), head(0), count(0), closed(false) {}
+    ~Queue() { delete[] q; }
+    void push(X *x) {
+        std::unique_lock<std::mutex> l(m);
+        c.wait(l, [&]{ return count<n; });
+        q[(head+count++)%n] = x;
+        c.notify_all();
+    }
+    X *pop() {// 0 if queue is closed and empty
+        std::unique_lock<std::mutex> l(m);
+        c.wait(l, [&]{ return count>0 || closed; });
+        if(count==0) return 0;
+        X *x(q[head]);
+        head = (head+1)%n;
+        count--;
+        c.notify_all();
+        return x;
+    }
+    void close() {
+        std::lock_guard<std::mutex> l(m);
+        closed = true;
+        c.notify_all();
+    }
+};
+
+template<class X>
+struct Buffers {// k buffers passed around by free and full queues
+    X *x;
+    Queue<X> free,full;
+    explicit Buffers(int k) : x(new X[k]), free(k), full(k) {
+        for(int i=0; i<k; i++) free.push(x+i);
+    }
+    ~Buffers() { delete[] x; }
+};
+
+template<class T>
+void stream(const Reconstructor<T>& rec, bool (*read)(Mat<T>&, void*),
+            void (*write)(const Mat<T>&, void*), void *arg, long budget)
+// read(A,arg) = fill next sinogram A and return true,
+//               or return false at end of stream
+// write(B,arg) = called with restored images in order of input
+// budget = bytes of slice buffers, work planes and filtering
+//   scratch;
+//   sinograms, Radon data and images get 2, 3 and 2 buffers
+//   (one for each stage using them and one in queue),
+//   and buffers are added in turn while budget allows (up to 8
+//   of each kind);
+//   if budget==0, minimum numbers are used
+// stages run concurrently; transforms in a stage use the
+//   thread pool when no other stage holds it (see Parallel.h)
+{
+    int i,n(rec.size()),k[3] = {2,3,2};
+    long b[3],s(sizeof(T));
+    b[0] = rec.rays()*long(rec.directions())*s;// sinogram
+    b[1] = 8L*n*n*s;// Radon data
+    b[2] = long(n)*n*s;// image
+    long w(4L*n*n*s + b[0]*k[0] + b[1]*k[1] + b[2]*k[2]);// and work planes
+    w += 32L*n*s*NumThreads();// start thread pool before stages use it
+                              // (filtering scratch in CT.cpp)
+    if(budget && w > budget) error("memory budget too small");
+    for(i=0; budget && i<3*6; i++)
+        if(k[i%3] < 8 && w + b[i%3] <= budget) { w += b[i%3]; k[i%3]++; }
+    Buffers<Mat<T> > A(k[0]);
+    Buffers<RadonT<T> > d(k[1]);
+    Queue<RadonT<T> > e(k[1]);// filtered Radon data
+    Buffers<Mat<T> > B(k[2]);
+    std::thread t[4];
+    t[0] = std::thread([&]{// read
+        Mat<T> *a;
+        while((a = A.free.pop())) {
+            if(!read(*a,arg)) break;
+            A.full.push(a);
+        }
+        A.full.close();
+    });
+    t[1] = std::thread([&]{// resampling
+        Mat<T> *a;
+        RadonT<T> *p;
+        while((a = A.full.pop())) {
+            p = d.free.pop();
+            rec.RadonFromSinogram(*p,*a);
+            A.free.push(a);
+            d.full.push(p);
+        }
+        d.full.close();
+    });
+    t[2] = std::thread([&]{// filtering
+        RadonT<T> *p;
+        while((p = d.full.pop())) {
+            rec.filtering(*p);
+            e.push(p);
+        }
+        e.close();
+    });
+    t[3] = std::thread([&]{// back projection
+        Workspace<T> ws;
+        RadonT<T> *p;
+        Mat<T> *b;
+        while((p = e.pop())) {
+            b = B.free.pop();
+            BackScan(*b,*p,ws);
+            d.free.push(p);
+            B.full.push(b);
+        }
+        B.full.close();
+    });
+    Mat<T> *c;
+    while((c = B.full.pop())) {// write in caller
+        write(*c,arg);
+        B.free.push(c);
+    }
+    for(i=0; i<4; i++) t[i].join();
+}
+
+template void stream(const Reconstructor<float>&, bool (*)(Mat_SP&, void*),
+                     void (*)(const Mat_SP&, void*), void*, long);
+template void stream(const Reconstructor<double>&, bool (*)(Mat_DP&, void*),
+                     void (*)(const Mat_DP&, void*), void*, long);